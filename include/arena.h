@@ -0,0 +1,48 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+
+#include "utils.h"
+
+/**
+ * Monotonic memory arena for long-lived scene data
+ * Objects are packed one after another into large blocks instead of being
+ * scattered across the heap, and all of the memory is returned in one step
+ * when the arena is destroyed. The arena must outlive everything made from it.
+ */
+class arena {
+ public:
+  /**
+   * Construct an empty arena
+   *
+   * @param blockSize Size in bytes of the first block requested from the heap
+   */
+  explicit arena(std::size_t blockSize = 64 * 1024) : resource(blockSize) {}
+
+  arena(const arena&) = delete;
+  arena& operator=(const arena&) = delete;
+
+  /**
+   * Construct an object in the arena
+   * The object and its shared_ptr control block share one arena allocation
+   *
+   * @param args Constructor arguments for T
+   * @return Shared pointer to the new object
+   */
+  template <typename T, typename... Args>
+  shared_ptr<T> make(Args&&... args) {
+    return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(&resource),
+                                   std::forward<Args>(args)...);
+  }
+
+  // Memory resource for arena-backed containers (e.g. std::pmr::vector)
+  std::pmr::memory_resource* get() { return &resource; }
+
+ private:
+  std::pmr::monotonic_buffer_resource resource;  // Backing block allocator
+};
+
+#endif
@@ -1,14 +1,30 @@
 #ifndef CAMERA_H
 #define CAMERA_H
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
 
+#include "denoiser.h"
+#include "filter.h"
+#include "framebuffer.h"
 #include "hittable.h"
+#include "imageIO.h"
 #include "material.h"
+#include "parallel.h"
+#include "splatBuffer.h"
+#include "toneMapper.h"
+#include "traversal.h"
 
 /**
  * Camera class responsible for generating rays and rendering the scene
  * Controls viewport, lens properties, and handles the rendering process
+ * Rendering methods are templates over the scene type (World), which needs
+ * only a hit() query: a hittableList dispatches through virtual calls, while
+ * a staticScene instantiates the integrator for its fixed primitive types
  */
 class camera {
  public:
@@ -28,6 +44,46 @@ class camera {
   double defocusAngle = 0;           // Variation angle of rays through each pixel
   double focusDist = 10;             // Distance from camera to plane of perfect focus
 
+  // Denoising and feature buffer (AOV) properties
+  bool denoise = false;              // Run the feature-guided denoiser after rendering
+  std::string aovPrefix = "";        // If set, write albedo/normal/depth images with this path prefix
+  denoiser denoiserSettings;         // Parameters of the denoising filter
+
+  // Output color pipeline properties
+  toneMapper toneMapping;            // Exposure, tone curve and encoding of the written image
+  std::string hdrPath = "";          // If set, also write the linear HDR image (PFM) to this path
+
+  // Reproducibility properties
+  std::uint64_t seed = 0;            // If non-zero, renderImage() reseeds per row, tile or sample pass so output is repeatable
+
+  // Pixel reconstruction properties
+  filterType filter = filterType::box;  // Filter spreading each sample over nearby pixels (box when gathering features)
+
+  // Parallel work partitioning properties
+  bool partitionSamples = false;     // Split work across threads by sample index instead of by row
+  splatMode sampleAccumulation = splatMode::atomicAdd;  // How sample-partitioned threads combine results (perThread costs a frame per thread)
+  traversalOrder traversal = traversalOrder::scanline;  // Order in which pixels are visited
+
+  // Spectral rendering properties
+  bool spectral = false;             // Trace hero wavelengths instead of RGB (enables dispersion)
+
+  // Render region properties (for render(), renderImage() and accumulatePass())
+  bool useRenderRegion = false;      // Trace only the pixels inside the region below
+  int regionX = 0;                   // Left column of the region
+  int regionY = 0;                   // Top row of the region
+  int regionWidth = 0;               // Region width in pixels
+  int regionHeight = 0;              // Region height in pixels
+  int regionPadding = 0;             // Extra pixels traced around the region for filters (e.g. denoising)
+  bool cropToRegion = false;         // render() writes only the region instead of the full frame
+  std::string mergeBase = "";        // If set, render() takes pixels outside the region from this PPM
+
+  // Coarse-to-fine preview properties
+  int coarsestBlock = 8;             // Pixels per side of a first-level preview block (power of two)
+  int tileSize = 32;                 // Pixels per side of a tile (a multiple of coarsestBlock)
+  bool useRegionOfInterest = false;  // Refine tiles nearest the region of interest first
+  double roiX = 0.5;                 // Region of interest, as a fraction of image width
+  double roiY = 0.5;                 // Region of interest, as a fraction of image height
+
   /**
    * Render the scene to an output stream
    * Outputs in PPM format, which consists of:
@@ -37,37 +93,247 @@ class camera {
    * - Followed by RGB triplets for each pixel
    * 
    * @param world The collection of objects in the scene
+   * @param materials The materials referenced by objects in the scene
+   * @return true if an image was written, false if the render region lies outside the image
+   */
+  template <typename World>
+  bool render(const World &world, const materialList &materials) {
+    framebuffer fb = renderImage(world, materials);
+
+    if (useRenderRegion && (regionX0 == regionX1 || regionY0 == regionY1)) {
+      std::cerr << "Render region " << regionWidth << "x" << regionHeight << " at ("
+                << regionX << ", " << regionY << ") has no pixels inside the "
+                << imageWidth << "x" << imageHeight << " image\n";
+      return false;
+    }
+
+    // Post-processing only sees the traced pixels, including the padding
+    if (useRenderRegion) {
+      fb = fb.cropped(traceX0, traceY0, traceX1 - traceX0, traceY1 - traceY0);
+    }
+
+    // Feature buffers are written before denoising so they reflect the raw render
+    if (!aovPrefix.empty()) writeFeatureImages(aovPrefix, fb);
+    if (denoise) denoiserSettings.apply(fb);
+
+    // The padding has served the filters; keep only the region itself
+    if (useRenderRegion) {
+      fb = fb.cropped(regionX0 - traceX0, regionY0 - traceY0, regionX1 - regionX0,
+                      regionY1 - regionY0);
+    }
+
+    // The HDR image is saved before tone mapping so it can be re-exposed later,
+    // with the same extent as the 8-bit output
+    if (!hdrPath.empty()) {
+      if (useRenderRegion && !cropToRegion) {
+        writeImageHDR(hdrPath, regionInFrame(fb));
+      } else {
+        writeImageHDR(hdrPath, fb);
+      }
+    }
+
+    if (useRenderRegion && !cropToRegion) {
+      writeRegionIntoFrame(fb);
+    } else {
+      writeImage(std::cout, fb, toneMapping);
+    }
+    return true;
+  }
+
+  /**
+   * Render the scene into a floating point image
+   * Feature buffers are filled when denoising or AOV output is enabled
+   *
+   * @param world The collection of objects in the scene
+   * @param materials The materials referenced by objects in the scene
+   * @return The rendered image in linear color
    */
-  void render(const hittable &world) {
+  template <typename World>
+  framebuffer renderImage(const World &world, const materialList &materials) {
     // Prepare camera geometry and pixel layout
     initialize();
 
-    // Output PPM header
-    std::cout << "P3\n" << imageWidth << " " << imageHeight << "\n255\n";
+    bool withFeatures = denoise || !aovPrefix.empty();
+    framebuffer fb(imageWidth, imageHeight, withFeatures);
+
+    // Feature buffers are only gathered when every sample stays in its own pixel
+    if ((partitionSamples || filter != filterType::box) && !withFeatures) {
+      renderSplatted(world, materials, fb);
+      return fb;
+    }
     
-    // Render each pixel of the image
-    for (int j = 0; j < imageHeight; j++) {
-      // Display progress
-      std::clog << "\rScanlines remaining: " << (imageHeight - j) << " "
-                << std::flush;
-                
-      for (int i = 0; i < imageWidth; i++) {
-        // Initialize pixel color to black
-        color pixelColor(0, 0, 0);
-        
-        // Antialiasing: sample multiple rays per pixel
-        for (int s = 0; s < samplesPerPixel; s++) {
-          ray r = getRay(i, j);
-          pixelColor += rayColor(r, maxDepth, world);
+    // Trace every sample of one pixel and store the averages
+    auto shadePixel = [&](int i, int j) {
+      // Initialize pixel color and features to zero
+      color pixelColor(0, 0, 0);
+      surfaceFeatures pixelFeatures;
+      double luminanceSum = 0, luminanceSquares = 0;
+      
+      // Antialiasing: sample multiple rays per pixel
+      for (int s = 0; s < samplesPerPixel; s++) {
+        if (withFeatures) {
+          surfaceFeatures sampleFeatures;
+          color c = sampleColor(i, j, world, materials, &sampleFeatures);
+          double l = luminance(c);
+          pixelColor += c;
+          luminanceSum += l;
+          luminanceSquares += l * l;
+          pixelFeatures.albedo += sampleFeatures.albedo;
+          pixelFeatures.normal += sampleFeatures.normal;
+          pixelFeatures.depth += sampleFeatures.depth;
+        } else {
+          pixelColor += sampleColor(i, j, world, materials);
         }
-        
-        // Write the pixel color with scaling for sample count
-        writeColor(std::cout, pixelColor * pixelSamplesScale);
       }
-    }
+      
+      // Store the pixel color and features with scaling for sample count
+      int p = fb.index(i, j);
+      fb.pixels[p] = pixelColor * pixelSamplesScale;
+      if (withFeatures) {
+        fb.albedo[p] = pixelFeatures.albedo * pixelSamplesScale;
+        fb.normal[p] = pixelFeatures.normal * pixelSamplesScale;
+        fb.depth[p] = pixelFeatures.depth * pixelSamplesScale;
+
+        // Variance of the mean from the sample variance; a lone sample is
+        // taken to be as uncertain as it is bright
+        double mean = luminanceSum * pixelSamplesScale;
+        fb.variance[p] = samplesPerPixel > 1
+                             ? std::max(luminanceSquares - luminanceSum * mean, 0.0) /
+                                   (samplesPerPixel - 1) * pixelSamplesScale
+                             : mean * mean;
+      }
+    };
+
+    // Render rows or tiles of the image in parallel
+    std::mutex progressMutex;
+    int unitsRemaining = traversalUnits();
+    parallelFor(0, traversalUnits(), [&](int unit) {
+      if (seed) seedRandom(seed, unit);
+      forEachPixelOf(unit, shadePixel);
+
+      // Display progress
+      std::lock_guard<std::mutex> lock(progressMutex);
+      std::clog << (traversal == traversalOrder::scanline ? "\rScanlines" : "\rTiles")
+                << " remaining: " << --unitsRemaining << " " << std::flush;
+    });
     
     // Render complete
     std::clog << "\rDone" << std::endl;
+    return fb;
+  }
+
+  /**
+   * Prepare for progressive rendering
+   * Must be called again whenever a camera property changes
+   *
+   * @param accum Accumulation buffer, resized to the image and cleared
+   */
+  void beginProgressive(framebuffer &accum) {
+    initialize();
+    accum.reset(imageWidth, imageHeight);
+  }
+
+  /**
+   * Add one sample to every pixel of an accumulation buffer
+   * The buffer holds sums, so divide by the number of passes to display it
+   *
+   * @param world The collection of objects in the scene
+   * @param materials The materials referenced by objects in the scene
+   * @param accum Accumulation buffer prepared by beginProgressive()
+   * @param cancel If non-null, the pass stops early once this becomes true
+   * @return true if the pass completed, false if it was cancelled
+   */
+  template <typename World>
+  bool accumulatePass(const World &world, const materialList &materials,
+                      framebuffer &accum,
+                      const std::atomic<bool> *cancel = nullptr) {
+    parallelFor(0, traversalUnits(), [&](int unit) {
+      if (cancel && *cancel) return;
+      forEachPixelOf(unit, [&](int i, int j) {
+        accum.pixels[accum.index(i, j)] += sampleColor(i, j, world, materials);
+      });
+    });
+    return !(cancel && *cancel);
+  }
+
+  /**
+   * Render a full-frame preview at increasing resolution, most urgent tiles first
+   * Each tile is refined through levels of decreasing block size: the first
+   * level traces one ray per coarsestBlock x coarsestBlock block and each
+   * following level halves the block size, reusing the rays already traced.
+   * Every block is filled with its sample, so the image is always complete.
+   * The first level covers every tile; after that tiles advance independently
+   * through a priority queue, so tiles near the region of interest (or with
+   * high estimated variance) reach full resolution while others are still
+   * coarse. A frame is reported after the first level and after every batch
+   * of refinements. The last frame has exactly one sample in every traced
+   * pixel; pixels outside the render region stay black, as in accumulatePass().
+   *
+   * @param world The collection of objects in the scene
+   * @param materials The materials referenced by objects in the scene
+   * @param fb Image to render into; also serves as beginProgressive() for accumulatePass()
+   * @param onFrame Called as onFrame(fb, block) after each batch, where block is the largest block size left in fb
+   * @param cancel If non-null, rendering stops early once this becomes true
+   * @return true if every tile reached full resolution, false if cancelled
+   */
+  template <typename World, typename F>
+  bool renderCoarseToFine(const World &world, const materialList &materials,
+                          framebuffer &fb, F &&onFrame,
+                          const std::atomic<bool> *cancel = nullptr) {
+    beginProgressive(fb);
+
+    // Only tiles overlapping the traced rectangle are refined
+    int firstTileX = traceX0 / tileSize, firstTileY = traceY0 / tileSize;
+    int tilesX = traceX1 > traceX0 ? (traceX1 - 1) / tileSize - firstTileX + 1 : 0;
+    int tilesY = traceY1 > traceY0 ? (traceY1 - 1) / tileSize - firstTileY + 1 : 0;
+    int tileCount = tilesX * tilesY;
+    int batchSize = std::max(tileCount / 2, 1);  // Tile refinements between frames after the first level
+
+    refineQueue.clear();
+    refineBatch.clear();
+    refineQueue.reserve(tileCount);
+    refineBatch.reserve(tileCount);
+
+    // Most urgent tile on top; ties go to the coarser tile, then scanline order
+    auto lessUrgent = [](const tileRefinement &a, const tileRefinement &b) {
+      double ua = a.priority * a.block, ub = b.priority * b.block;
+      if (ua != ub) return ua < ub;
+      if (a.block != b.block) return a.block < b.block;
+      return a.ty != b.ty ? a.ty > b.ty : a.tx > b.tx;
+    };
+
+    for (int t = 0; t < tileCount; t++) {
+      refineBatch.push_back({firstTileX + t % tilesX, firstTileY + t / tilesX, coarsestBlock, 0});
+    }
+
+    while (!refineBatch.empty()) {
+      parallelFor(0, static_cast<int>(refineBatch.size()), [&](int k) {
+        if (cancel && *cancel) return;
+        tileRefinement &tile = refineBatch[k];
+        refineTile(world, materials, fb, tile.tx, tile.ty, tile.block);
+        tile.priority = tilePriorityFor(fb, tile.tx, tile.ty, tile.block);
+      });
+      if (cancel && *cancel) return false;
+
+      // Tiles not yet at full resolution wait for their next level
+      int largestBlock = 1;
+      for (const tileRefinement &tile : refineBatch) {
+        if (tile.block == 1) continue;
+        refineQueue.push_back(tile);
+        std::push_heap(refineQueue.begin(), refineQueue.end(), lessUrgent);
+      }
+      for (const tileRefinement &tile : refineQueue) largestBlock = std::max(largestBlock, tile.block);
+      onFrame(fb, largestBlock);
+
+      refineBatch.clear();
+      while (!refineQueue.empty() && static_cast<int>(refineBatch.size()) < batchSize) {
+        std::pop_heap(refineQueue.begin(), refineQueue.end(), lessUrgent);
+        refineBatch.push_back(refineQueue.back());
+        refineBatch.back().block /= 2;
+        refineQueue.pop_back();
+      }
+    }
+    return true;
   }
 
  private:
@@ -86,6 +352,272 @@ class camera {
   vec3 defocusDiskU;         // Horizontal component of defocus disk
   vec3 defocusDiskV;         // Vertical component of defocus disk
 
+  // Reconstruction filter with its weight table, rebuilt when filter changes
+  reconstructionFilter pixelFilter;
+
+  /**
+   * A tile of the image, its current level and how urgently it should be refined
+   */
+  struct tileRefinement {
+    int tx, ty;       // Tile coordinates (in tiles, not pixels)
+    int block;        // Block size the tile has been (or is being) refined to
+    double priority;  // Importance of the tile; scaled by block size when ranking
+  };
+
+  // Tile traversal layout
+  int tilesX;                // Number of tile columns
+  std::vector<int> tileOrder;  // Tile indices in traversal order (empty for scanline)
+
+  // Coarse-to-fine tile lists (storage reused between previews)
+  std::vector<tileRefinement> refineQueue;  // Heap of tiles awaiting their next level
+  std::vector<tileRefinement> refineBatch;  // Tiles refined before the next frame
+
+  // Pixel rectangles (half-open, clipped to the image); the whole image without a render region
+  int regionX0, regionY0, regionX1, regionY1;  // Render region
+  int traceX0, traceY0, traceX1, traceY1;      // Pixels traced: the region plus its padding
+
+  /**
+   * Render the image by splatting samples into a lock-free splat buffer
+   * Each sample is spread over the pixels within the reconstruction filter's
+   * radius, so neighboring rows and tiles write to the same pixels. Each row
+   * or tile is splatted into its thread's small exclusive buffer first, and
+   * only the border its neighbors also reach is added to the image atomically.
+   * With partitionSamples, each task instead traces one sample for every
+   * pixel, so all threads contribute to every pixel; this keeps many cores
+   * busy even when the image has fewer rows than there are threads.
+   *
+   * @param world The collection of objects in the scene
+   * @param materials The materials referenced by objects in the scene
+   * @param fb Image to write the filtered result to
+   */
+  template <typename World>
+  void renderSplatted(const World &world, const materialList &materials,
+                      framebuffer &fb) {
+    splatBuffer accum(imageWidth, imageHeight,
+                      partitionSamples ? sampleAccumulation : splatMode::atomicAdd);
+
+    auto traceSample = [&](splatBuffer &target, int i, int j) {
+      vec3 offset = sampleSquare();
+      splatSample(target, i, j, offset, sampleColor(i, j, offset, world, materials));
+    };
+
+    std::mutex progressMutex;
+    if (partitionSamples) {
+      int samplesRemaining = samplesPerPixel;
+      parallelFor(0, samplesPerPixel, [&](int sample) {
+        if (seed) seedRandom(seed, sample);
+        for (int unit = 0; unit < traversalUnits(); unit++) {
+          forEachPixelOf(unit, [&](int i, int j) { traceSample(accum, i, j); });
+        }
+
+        // Display progress
+        std::lock_guard<std::mutex> lock(progressMutex);
+        std::clog << "\rSamples remaining: " << --samplesRemaining << " "
+                  << std::flush;
+      });
+    } else {
+      // Farthest a splat reaches, in pixels, from the pixel its sample was traced through
+      int reach = static_cast<int>(std::ceil(pixelFilter.radius + 0.5));
+      std::vector<splatBuffer> tiles(threadPool::instance().size(),
+                                     splatBuffer::exclusiveBuffer());
+
+      int unitsRemaining = traversalUnits();
+      parallelFor(0, traversalUnits(), [&](int unit) {
+        if (seed) seedRandom(seed, unit);
+        int x0, y0, x1, y1;
+        unitBounds(unit, x0, y0, x1, y1);
+
+        splatBuffer &tile = tiles[threadPool::threadIndex()];
+        int tileX0 = std::max(x0 - reach, 0), tileY0 = std::max(y0 - reach, 0);
+        tile.reset(tileX0, tileY0, std::min(x1 + reach, imageWidth) - tileX0,
+                   std::min(y1 + reach, imageHeight) - tileY0);
+        forEachPixelOf(unit, [&](int i, int j) {
+          for (int s = 0; s < samplesPerPixel; s++) traceSample(tile, i, j);
+        });
+
+        // Pixels further than the reach inside the unit receive only its samples
+        accum.addTile(tile, x0 + reach, y0 + reach, x1 - reach, y1 - reach);
+
+        // Display progress
+        std::lock_guard<std::mutex> lock(progressMutex);
+        std::clog << (traversal == traversalOrder::scanline ? "\rScanlines" : "\rTiles")
+                  << " remaining: " << --unitsRemaining << " " << std::flush;
+      });
+    }
+
+    accum.resolve(fb);
+    std::clog << "\rDone" << std::endl;
+  }
+
+  /**
+   * Add a sample to every pixel within the reconstruction filter's radius
+   *
+   * @param accum Buffer to splat into; must cover every pixel the sample reaches
+   * @param i Horizontal index of the pixel the sample was traced through
+   * @param j Vertical index of the pixel the sample was traced through
+   * @param offset Sample position relative to that pixel's center
+   * @param c Sample color
+   */
+  void splatSample(splatBuffer &accum, int i, int j, const vec3 &offset,
+                   const color &c) const {
+    // A box filter never reaches past the pixel the sample was traced through
+    if (pixelFilter.type == filterType::box) {
+      accum.add(i, j, c);
+      return;
+    }
+
+    double x = i + offset.x(), y = j + offset.y();
+    int x0 = std::max(static_cast<int>(std::ceil(x - pixelFilter.radius)), 0);
+    int x1 = std::min(static_cast<int>(std::floor(x + pixelFilter.radius)), imageWidth - 1);
+    int y0 = std::max(static_cast<int>(std::ceil(y - pixelFilter.radius)), 0);
+    int y1 = std::min(static_cast<int>(std::floor(y + pixelFilter.radius)), imageHeight - 1);
+
+    for (int py = y0; py <= y1; py++) {
+      double wy = pixelFilter.weight(py - y);
+      if (wy == 0) continue;
+      for (int px = x0; px <= x1; px++) {
+        double w = wy * pixelFilter.weight(px - x);
+        if (w != 0) accum.add(px, py, c, w);
+      }
+    }
+  }
+
+  /**
+   * Place a rendered region in an otherwise black full-frame image
+   * Used for the HDR output, which has no base image to merge with
+   *
+   * @param region The finished render region (regionX1 - regionX0 pixels wide)
+   * @return The full frame
+   */
+  framebuffer regionInFrame(const framebuffer &region) const {
+    framebuffer frame(imageWidth, imageHeight);
+    for (int j = 0; j < region.height; j++) {
+      std::copy_n(region.pixels.begin() + region.index(0, j), region.width,
+                  frame.pixels.begin() + frame.index(regionX0, regionY0 + j));
+    }
+    return frame;
+  }
+
+  /**
+   * Write the full frame with a rendered region in place
+   * Pixels outside the region come from mergeBase when it is set and matches
+   * the frame size, and are black otherwise. Merging happens on display
+   * values, so the base image's pixels are kept exactly.
+   *
+   * @param region The finished render region (regionX1 - regionX0 pixels wide)
+   */
+  void writeRegionIntoFrame(const framebuffer &region) const {
+    std::vector<unsigned char> frame;
+    int baseWidth = 0, baseHeight = 0;
+    bool merged = !mergeBase.empty() && readImageBytes(mergeBase, baseWidth, baseHeight, frame);
+    if (merged && (baseWidth != imageWidth || baseHeight != imageHeight)) {
+      std::cerr << mergeBase << " is " << baseWidth << "x" << baseHeight
+                << ", not " << imageWidth << "x" << imageHeight << "\n";
+      merged = false;
+    }
+    if (!merged) frame.assign(3 * imageWidth * imageHeight, 0);
+
+    std::vector<unsigned char> bytes;
+    toneMapping.apply(region, bytes);
+    for (int j = 0; j < region.height; j++) {
+      std::copy_n(bytes.begin() + 3 * region.index(0, j), 3 * region.width,
+                  frame.begin() + 3 * (regionY0 + j) * imageWidth + 3 * regionX0);
+    }
+
+    writeImageBytes(std::cout, imageWidth, imageHeight, frame);
+  }
+
+  /**
+   * Estimate how important it is to refine a tile
+   * With a region of interest, importance falls off with the distance from
+   * it, measured in tiles; otherwise it is the luminance variance among the
+   * tile's samples. Tiles are ranked by importance times block size, since
+   * refining a coarser tile changes the image more.
+   *
+   * @param fb Image rendered so far
+   * @param tx Horizontal tile coordinate
+   * @param ty Vertical tile coordinate
+   * @param spacing Distance between the samples already traced in the tile
+   * @return Importance of the tile (non-negative)
+   */
+  double tilePriorityFor(const framebuffer &fb, int tx, int ty, int spacing) const {
+    int x0 = tx * tileSize, y0 = ty * tileSize;
+    int x1 = std::min(x0 + tileSize, traceX1), y1 = std::min(y0 + tileSize, traceY1);
+
+    if (useRegionOfInterest) {
+      double dx = (0.5 * (x0 + x1) - roiX * imageWidth) / tileSize;
+      double dy = (0.5 * (y0 + y1) - roiY * imageHeight) / tileSize;
+      return 1 / (1 + dx * dx + dy * dy);
+    }
+
+    double sum = 0, sumSquares = 0;
+    int count = 0;
+    for (int by = y0; by < y1; by += spacing) {
+      if (by + spacing <= traceY0) continue;
+      for (int bx = x0; bx < x1; bx += spacing) {
+        if (bx + spacing <= traceX0) continue;
+        double l = luminance(fb.pixels[fb.index(std::max(bx, traceX0), std::max(by, traceY0))]);
+        sum += l;
+        sumSquares += l * l;
+        count++;
+      }
+    }
+    double mean = sum / count;
+    return std::max(sumSquares / count - mean * mean, 0.0);
+  }
+
+  /**
+   * Trace one level of a tile for renderCoarseToFine()
+   * Traces one ray per block at its top-left traced pixel and fills the traced
+   * part of the block with it; blocks whose sample pixel was already traced at
+   * the coarser level keep their value
+   *
+   * @param world The collection of objects in the scene
+   * @param materials The materials referenced by objects in the scene
+   * @param fb Image to render into
+   * @param tx Horizontal tile coordinate
+   * @param ty Vertical tile coordinate
+   * @param block Pixels per side of each block at this level
+   */
+  template <typename World>
+  void refineTile(const World &world, const materialList &materials,
+                  framebuffer &fb, int tx, int ty, int block) {
+    int x0 = tx * tileSize, y0 = ty * tileSize;
+    int x1 = std::min(x0 + tileSize, traceX1), y1 = std::min(y0 + tileSize, traceY1);
+
+    for (int by = y0; by < y1; by += block) {
+      if (by + block <= traceY0) continue;
+      for (int bx = x0; bx < x1; bx += block) {
+        if (bx + block <= traceX0) continue;
+
+        // Blocks are clipped to the traced rectangle, so the sample pixel is
+        // the block's top-left pixel moved inside it; the coarser block
+        // containing this one traced the same pixel if their clipped corners agree
+        int sx = std::max(bx, traceX0), sy = std::max(by, traceY0);
+        bool tracedBefore = block < coarsestBlock &&
+                            std::max(bx - bx % (2 * block), traceX0) == sx &&
+                            std::max(by - by % (2 * block), traceY0) == sy;
+        if (tracedBefore) continue;
+
+        color c = sampleColor(sx, sy, world, materials);
+        for (int y = sy; y < std::min(by + block, y1); y++) {
+          for (int x = sx; x < std::min(bx + block, x1); x++) {
+            fb.pixels[fb.index(x, y)] = c;
+          }
+        }
+      }
+    }
+  }
+
+  /**
+   * Features of the first surface a camera ray hits, used to guide the denoiser
+   */
+  struct surfaceFeatures {
+    color albedo;      // Albedo of the first non-specular surface (background color for misses)
+    vec3 normal;       // Normal of the first non-specular surface (zero for misses)
+    double depth = 0;  // Distance to the first surface hit (zero for misses)
+  };
+
   /**
    * Initialize camera geometry and calculate derived values
    * Sets up the viewport, pixel locations, and camera orientation
@@ -130,21 +662,156 @@ class camera {
         focusDist * std::tan(degreesToRadians(defocusAngle / 2));
     defocusDiskU = u * defocusRadius;  // Horizontal radius of defocus disk
     defocusDiskV = v * defocusRadius;  // Vertical radius of defocus disk
+
+    if (pixelFilter.type != filter) pixelFilter = reconstructionFilter(filter);
+
+    // Clip the render region, and the pixels traced for it, to the image
+    regionX0 = traceX0 = 0;
+    regionY0 = traceY0 = 0;
+    regionX1 = traceX1 = imageWidth;
+    regionY1 = traceY1 = imageHeight;
+    if (useRenderRegion) {
+      regionX0 = std::clamp(regionX, 0, imageWidth);
+      regionY0 = std::clamp(regionY, 0, imageHeight);
+      regionX1 = std::clamp(regionX + regionWidth, regionX0, imageWidth);
+      regionY1 = std::clamp(regionY + regionHeight, regionY0, imageHeight);
+      traceX0 = std::max(regionX0 - regionPadding, 0);
+      traceY0 = std::max(regionY0 - regionPadding, 0);
+      traceX1 = std::min(regionX1 + regionPadding, imageWidth);
+      traceY1 = std::min(regionY1 + regionPadding, imageHeight);
+    }
+
+    // Lay out tiles along the traversal curve (reusing storage between frames),
+    // skipping tiles that hold no traced pixels
+    tilesX = (imageWidth + tileSize - 1) / tileSize;
+    if (traversal == traversalOrder::scanline) {
+      tileOrder.clear();
+    } else {
+      int tilesY = (imageHeight + tileSize - 1) / tileSize;
+      buildTileOrder(traversal, tilesX, tilesY, tileOrder);
+      std::erase_if(tileOrder, [&](int tile) {
+        int x0 = (tile % tilesX) * tileSize, y0 = (tile / tilesX) * tileSize;
+        return x0 >= traceX1 || x0 + tileSize <= traceX0 ||
+               y0 >= traceY1 || y0 + tileSize <= traceY0;
+      });
+    }
+  }
+
+  /**
+   * Number of parallel work units for the traversal order
+   * Units are traced rows for scanline traversal and traced tiles otherwise
+   */
+  int traversalUnits() const {
+    if (traversal == traversalOrder::scanline) return traceY1 - traceY0;
+    return static_cast<int>(tileOrder.size());
+  }
+
+  /**
+   * Rectangle of pixels traced by a work unit (half-open)
+   *
+   * @param unit Index of the row or tile, in [0, traversalUnits())
+   * @param x0 Receives the left column
+   * @param y0 Receives the top row
+   * @param x1 Receives the column after the right edge
+   * @param y1 Receives the row after the bottom edge
+   */
+  void unitBounds(int unit, int &x0, int &y0, int &x1, int &y1) const {
+    if (traversal == traversalOrder::scanline) {
+      x0 = traceX0;
+      x1 = traceX1;
+      y0 = traceY0 + unit;
+      y1 = y0 + 1;
+      return;
+    }
+
+    int tileX0 = (tileOrder[unit] % tilesX) * tileSize;
+    int tileY0 = (tileOrder[unit] / tilesX) * tileSize;
+    x0 = std::max(tileX0, traceX0);
+    y0 = std::max(tileY0, traceY0);
+    x1 = std::min(tileX0 + tileSize, traceX1);
+    y1 = std::min(tileY0 + tileSize, traceY1);
+  }
+
+  /**
+   * Visit every traced pixel of a work unit in traversal order
+   * Rows are visited left to right; tiles are visited in Z-order
+   *
+   * @param unit Index of the row or tile, in [0, traversalUnits())
+   * @param fn Called as fn(i, j) for every pixel of the unit
+   */
+  template <typename F>
+  void forEachPixelOf(int unit, F &&fn) const {
+    if (traversal == traversalOrder::scanline) {
+      for (int i = traceX0; i < traceX1; i++) fn(i, traceY0 + unit);
+      return;
+    }
+
+    int x0 = (tileOrder[unit] % tilesX) * tileSize;
+    int y0 = (tileOrder[unit] / tilesX) * tileSize;
+    int side = nextPowerOfTwo(tileSize);
+    for (int k = 0; k < side * side; k++) {
+      int dx, dy;
+      mortonDecode(static_cast<uint32_t>(k), dx, dy);
+      if (dx >= tileSize || dy >= tileSize) continue;
+
+      int i = x0 + dx, j = y0 + dy;
+      if (i >= traceX0 && i < traceX1 && j >= traceY0 && j < traceY1) fn(i, j);
+    }
+  }
+
+  /**
+   * Trace one camera sample through a pixel and return its linear RGB color
+   * In spectral mode the sample carries a fresh set of hero wavelengths and is
+   * converted to RGB here, so everything downstream stays RGB
+   *
+   * @param i Horizontal pixel index
+   * @param j Vertical pixel index
+   * @param world The scene to trace rays against
+   * @param materials The materials referenced by objects in the scene
+   * @param features If non-null, receives the features of the first surface hit
+   * @return Color estimate for this sample
+   */
+  template <typename World>
+  color sampleColor(int i, int j, const World &world,
+                    const materialList &materials,
+                    surfaceFeatures *features = nullptr) {
+    return sampleColor(i, j, sampleSquare(), world, materials, features);
+  }
+
+  /**
+   * Trace one camera sample through a given point of a pixel
+   *
+   * @param i Horizontal pixel index
+   * @param j Vertical pixel index
+   * @param offset Sample position relative to the pixel center, in [-0.5,0.5]^2
+   * @param world The scene to trace rays against
+   * @param materials The materials referenced by objects in the scene
+   * @param features If non-null, receives the features of the first surface hit
+   * @return Color estimate for this sample
+   */
+  template <typename World>
+  color sampleColor(int i, int j, const vec3 &offset, const World &world,
+                    const materialList &materials,
+                    surfaceFeatures *features = nullptr) {
+    ray r = getRay(i, j, offset);
+    if (!spectral) return rayColor(r, maxDepth, world, materials, features);
+
+    auto lambda = sampledWavelengths::sampleUniform(randomDouble());
+    auto radiance = rayRadiance(r, maxDepth, world, materials, lambda, features);
+    return spectrumToRGB(radiance, lambda);
   }
 
   /**
    * Get a ray from the camera through a specific pixel
-   * Implements antialiasing by randomizing the ray origin (defocus blur)
-   * and the ray target (jittering within the pixel)
+   * Implements antialiasing by targeting a jittered point within the pixel
+   * and depth of field by randomizing the ray origin (defocus blur)
    * 
    * @param i Horizontal pixel index
    * @param j Vertical pixel index
+   * @param offset Jittered sample position relative to the pixel center
    * @return Ray from camera through the pixel
    */
-  ray getRay(int i, int j) {
-    // Get random offset within the pixel for antialiasing
-    auto offset = sampleSquare();
-    
+  ray getRay(int i, int j, const vec3 &offset) {
     // Calculate the point on the viewport for this pixel
     auto pixelSample = pixel00Loc + (i + offset.x()) * pixelDeltaU +
                        (j + offset.y()) * pixelDeltaV;
@@ -185,35 +852,125 @@ class camera {
    * @param r The ray to trace
    * @param depth Maximum number of bounces remaining
    * @param world The scene to trace rays against
+   * @param materials The materials referenced by objects in the scene
+   * @param features If non-null, receives the features of the first surface hit
    * @return Color value for this ray
    */
-  color rayColor(const ray &r, int depth, const hittable &world) {
+  template <typename World>
+  color rayColor(const ray &r, int depth, const World &world,
+                 const materialList &materials,
+                 surfaceFeatures *features = nullptr) {
     // If we've reached the ray bounce limit, return black (no more light)
     if (depth <= 0) return color(0, 0, 0);
     
     hitRecord rec;
     // Check for ray intersection with the scene, ignoring hits very near the ray origin
     if (world.hit(r, interval(0.001, INF), rec)) {
+      const material &mat = materials[rec.mat];
+
+      surfaceFeatures *nextFeatures = recordHitFeatures(features, r, rec, mat);
+
       ray scattered;
       color attenuation;
       
       // Let the material determine how the ray scatters
-      if (rec.mat->scatter(r, rec, attenuation, scattered)) {
+      if (scatter(mat, r, rec, attenuation, scattered)) {
         // Recursive call for the scattered ray
-        return attenuation * rayColor(scattered, depth - 1, world);
+        return attenuation * rayColor(scattered, depth - 1, world, materials, nextFeatures);
       }
       
       // If no scattering occurs, the ray is absorbed and we return black
       return color(0, 0, 0);
     }
     
-    // If no hit, return the background color (simple gradient)
+    // If no hit, return the background color
+    color sky = background(r);
+    recordMissFeatures(features, sky);
+    return sky;
+  }
+
+  /**
+   * Calculate the spectral radiance carried by a ray at a set of wavelengths
+   * Spectral counterpart of rayColor(); wavelength-dependent materials may
+   * terminate the secondary wavelengths along the way
+   *
+   * @param r The ray to trace
+   * @param depth Maximum number of bounces remaining
+   * @param world The scene to trace rays against
+   * @param materials The materials referenced by objects in the scene
+   * @param lambda The wavelengths carried by the path
+   * @param features If non-null, receives the features of the first surface hit
+   * @return Radiance at each of the path's wavelengths
+   */
+  template <typename World>
+  sampledSpectrum rayRadiance(const ray &r, int depth, const World &world,
+                              const materialList &materials,
+                              sampledWavelengths &lambda,
+                              surfaceFeatures *features = nullptr) {
+    if (depth <= 0) return sampledSpectrum(0.0);
+
+    hitRecord rec;
+    if (world.hit(r, interval(0.001, INF), rec)) {
+      const material &mat = materials[rec.mat];
+      surfaceFeatures *nextFeatures = recordHitFeatures(features, r, rec, mat);
+
+      ray scattered;
+      sampledSpectrum attenuation;
+      if (scatter(mat, r, rec, lambda, attenuation, scattered)) {
+        return attenuation *
+               rayRadiance(scattered, depth - 1, world, materials, lambda, nextFeatures);
+      }
+      return sampledSpectrum(0.0);
+    }
+
+    // The sky is treated as an illuminant with the background's color
+    color sky = background(r);
+    recordMissFeatures(features, sky);
+    return rgbToSpectrum(sky, lambda);
+  }
+
+  /**
+   * Background color seen by a ray that escapes the scene (simple gradient)
+   *
+   * @param r The escaping ray
+   * @return Color of the sky in the ray's direction
+   */
+  static color background(const ray &r) {
     vec3 unitDirection = unitVector(r.direction());
     auto a = 0.5 * (unitDirection.y() + 1.0);  // Scale y component to [0,1]
     
     // Linear interpolation between white and light blue based on y coordinate
     return (1.0 - a) * color(1.0, 1.0, 1.0) + a * color(0.5, 0.7, 1.0);
   }
+
+  /**
+   * Record denoiser features for a surface hit
+   * Depth comes from the first hit; albedo and normal come from the first
+   * non-specular hit so mirrors and glass keep the detail they show
+   *
+   * @param features Features being gathered, or null if not needed
+   * @param r The ray that hit the surface
+   * @param rec The completed hit record
+   * @param mat Material of the surface hit
+   * @return Where the next bounce should record features (null once resolved)
+   */
+  static surfaceFeatures *recordHitFeatures(surfaceFeatures *features, const ray &r,
+                                            const hitRecord &rec, const material &mat) {
+    if (!features) return nullptr;
+    if (features->depth == 0) features->depth = rec.t * r.direction().length();
+    if (isSpecular(mat)) return features;
+
+    features->albedo = featureAlbedo(mat);
+    features->normal = rec.normal;
+    return nullptr;
+  }
+
+  // Record denoiser features for a ray that escaped to the background
+  static void recordMissFeatures(surfaceFeatures *features, const color &sky) {
+    if (!features) return;
+    features->albedo = sky;
+    features->normal = vec3(0, 0, 0);
+  }
 };
 
 #endif
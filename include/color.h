@@ -29,6 +29,16 @@ inline double linearToGamma(double linearComponent) {
   return 0;
 }
 
+/**
+ * Perceived brightness of a linear color (Rec. 709 luma weights)
+ *
+ * @param c Color in linear space
+ * @return Relative luminance of the color
+ */
+inline double luminance(const color& c) {
+  return 0.2126 * c.x() + 0.7152 * c.y() + 0.0722 * c.z();
+}
+
 /**
  * Write a color to an output stream in PPM format
  * Applies gamma correction and maps from [0,1] to [0,255]
@@ -0,0 +1,161 @@
+#ifndef DENOISER_H
+#define DENOISER_H
+
+#include <cmath>
+#include <vector>
+
+#include "framebuffer.h"
+#include "parallel.h"
+
+/**
+ * Edge-avoiding à-trous wavelet denoiser
+ * Repeatedly blurs the image with a 5x5 B3-spline kernel whose taps spread
+ * further apart each pass, while edge-stopping weights computed from color,
+ * albedo, normal and depth keep the blur from crossing geometric and texture
+ * boundaries (Dammertz et al., "Edge-Avoiding À-Trous Wavelet Transform").
+ * The color weight is scaled by each pixel's estimated noise, as in SVGF
+ * (Schied et al., "Spatiotemporal Variance-Guided Filtering"): luminance
+ * differences well above the noise level are edges, smaller ones are noise.
+ * The variance is filtered along with the color, so later passes, which see
+ * less noise, blur less.
+ */
+class denoiser {
+ public:
+  int iterations = 2;       // Number of filter passes (kernel footprint doubles each pass)
+  double colorPhi = 4;      // Luminance edge-stopping threshold, in standard deviations of the noise
+  double albedoPhi = 0.1;   // Albedo edge-stopping sensitivity
+  double normalPhi = 0.05;  // Normal edge-stopping sensitivity
+  double depthPhi = 0.01;   // Relative depth edge-stopping sensitivity
+
+  /**
+   * Denoise the color buffer of an image in place
+   * Does nothing if the image was rendered without feature buffers
+   *
+   * @param fb Image to denoise, must carry albedo, normal and depth buffers
+   */
+  void apply(framebuffer& fb) const {
+    if (!fb.hasFeatures()) return;
+
+    std::vector<color> scratch(fb.size());
+    std::vector<color>* src = &fb.pixels;
+    std::vector<color>* dst = &scratch;
+
+    // The feature buffer keeps the variance as rendered; the passes work on copies
+    std::vector<double> variance(fb.variance), nextVariance(fb.size());
+    std::vector<double> deviation(fb.size());
+
+    for (int pass = 0, step = 1; pass < iterations; pass++, step *= 2) {
+      parallelFor(0, fb.height, [&](int j) {
+        noiseRow(fb, variance, deviation, j);
+      });
+
+      // Each row only reads from src and writes its own row of dst
+      parallelFor(0, fb.height, [&](int j) {
+        filterRow(fb, *src, *dst, variance, nextVariance, deviation, j, step);
+      });
+      std::swap(src, dst);
+      variance.swap(nextVariance);
+    }
+
+    // An odd number of passes leaves the result in the scratch buffer
+    if (src != &fb.pixels) fb.pixels.swap(scratch);
+  }
+
+ private:
+  /**
+   * Estimate the noise level of a row of pixels for the color weight
+   * Single-pixel variance estimates are themselves noisy, so they are
+   * blurred with a 3x3 Gaussian before taking the standard deviation
+   *
+   * @param fb Image providing the dimensions
+   * @param variance Luminance variance of every pixel after the previous pass
+   * @param deviation Receives the smoothed standard deviation of the row's pixels
+   * @param j Row to estimate
+   */
+  static void noiseRow(const framebuffer& fb, const std::vector<double>& variance,
+                       std::vector<double>& deviation, int j) {
+    static const double kernel[3] = {1.0 / 4, 1.0 / 2, 1.0 / 4};
+
+    for (int i = 0; i < fb.width; i++) {
+      double sum = 0, weightSum = 0;
+      for (int dy = -1; dy <= 1; dy++) {
+        int y = j + dy;
+        if (y < 0 || y >= fb.height) continue;
+        for (int dx = -1; dx <= 1; dx++) {
+          int x = i + dx;
+          if (x < 0 || x >= fb.width) continue;
+          double w = kernel[dx + 1] * kernel[dy + 1];
+          sum += w * variance[fb.index(x, y)];
+          weightSum += w;
+        }
+      }
+      deviation[fb.index(i, j)] = std::sqrt(sum / weightSum);
+    }
+  }
+
+  /**
+   * Filter a single row of the image for one à-trous pass
+   * The variance is filtered with the squared weights, which is the variance
+   * of the weighted average if neighboring pixels' noise is independent
+   *
+   * @param fb Image providing the feature buffers
+   * @param src Color buffer produced by the previous pass
+   * @param dst Color buffer receiving this pass
+   * @param variance Luminance variance of src
+   * @param nextVariance Receives the luminance variance of dst
+   * @param deviation Smoothed standard deviation of src's noise, from noiseRow()
+   * @param j Row to filter
+   * @param step Spacing between kernel taps in pixels
+   */
+  void filterRow(const framebuffer& fb, const std::vector<color>& src,
+                 std::vector<color>& dst, const std::vector<double>& variance,
+                 std::vector<double>& nextVariance,
+                 const std::vector<double>& deviation, int j, int step) const {
+    // Separable B3-spline weights for offsets -2..2
+    static const double kernel[5] = {1.0 / 16, 1.0 / 4, 3.0 / 8, 1.0 / 4, 1.0 / 16};
+
+    for (int i = 0; i < fb.width; i++) {
+      int p = fb.index(i, j);
+      const color& cP = src[p];
+      double lP = luminance(cP);
+      double phiColor = colorPhi * deviation[p] + 1e-10;
+      const color& aP = fb.albedo[p];
+      const vec3& nP = fb.normal[p];
+      double dP = fb.depth[p];
+
+      color sum(0, 0, 0);
+      double weightSum = 0, varianceSum = 0;
+
+      for (int dy = -2; dy <= 2; dy++) {
+        int y = j + dy * step;
+        if (y < 0 || y >= fb.height) continue;
+
+        for (int dx = -2; dx <= 2; dx++) {
+          int x = i + dx * step;
+          if (x < 0 || x >= fb.width) continue;
+
+          int q = fb.index(x, y);
+
+          // Edge-stopping weights: fall off as the neighbour's features diverge
+          double wColor = std::exp(-std::fabs(luminance(src[q]) - lP) / phiColor);
+          double wAlbedo = std::exp(-(fb.albedo[q] - aP).lengthSquared() / albedoPhi);
+          double wNormal = std::exp(-(fb.normal[q] - nP).lengthSquared() / normalPhi);
+          double wDepth = std::exp(-std::fabs(fb.depth[q] - dP) /
+                                   (depthPhi * std::fmax(dP, 1e-3) + 1e-8));
+
+          double w = kernel[dx + 2] * kernel[dy + 2] * wColor * wAlbedo *
+                     wNormal * wDepth;
+          sum += w * src[q];
+          weightSum += w;
+          varianceSum += w * w * variance[q];
+        }
+      }
+
+      // The centre tap always has weight > 0, so weightSum is never zero
+      dst[p] = sum / weightSum;
+      nextVariance[p] = varianceSum / (weightSum * weightSum);
+    }
+  }
+};
+
+#endif
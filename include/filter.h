@@ -0,0 +1,107 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <array>
+#include <cmath>
+
+#include "utils.h"
+
+/**
+ * Pixel reconstruction filter, weighting each sample by its distance from a pixel
+ */
+enum class filterType {
+  box,             // Each sample counts fully towards its own pixel only (radius 0.5)
+  gaussian,        // Gaussian with sigma 0.5, truncated at radius 1.5
+  mitchell,        // Mitchell-Netravali with B = C = 1/3 (radius 2); slightly sharpening
+  blackmanHarris,  // Four-term Blackman-Harris window (radius 1.5)
+};
+
+/**
+ * Separable reconstruction filter with a precomputed weight table
+ * A sample at offset (dx, dy) from a pixel center contributes to that pixel
+ * with weight weight(dx) * weight(dy). The filter is evaluated once into a
+ * table at construction, so splatting a sample costs only table lookups.
+ */
+class reconstructionFilter {
+ public:
+  filterType type;  // Filter shape
+  double radius;    // Distance in pixels beyond which the weight is zero
+
+  /**
+   * Construct a filter and tabulate its weights
+   *
+   * @param type Filter shape
+   */
+  explicit reconstructionFilter(filterType type = filterType::box)
+      : type(type), radius(radiusOf(type)) {
+    for (int k = 0; k < TABLE_SIZE; k++) {
+      table[k] = evaluate(type, (k + 0.5) * radius / TABLE_SIZE, radius);
+    }
+  }
+
+  /**
+   * One-dimensional filter weight
+   *
+   * @param d Offset from the pixel center in pixels (either sign)
+   * @return Weight of a sample at that offset (may be negative for Mitchell)
+   */
+  double weight(double d) const {
+    double x = std::fabs(d);
+    if (x >= radius) return 0;
+    return table[static_cast<int>(x * (TABLE_SIZE / radius))];
+  }
+
+ private:
+  static constexpr int TABLE_SIZE = 64;   // Table entries across [0, radius)
+  std::array<double, TABLE_SIZE> table;  // Weights at the center of each entry
+
+  // Support radius of each filter shape, in pixels
+  static double radiusOf(filterType type) {
+    switch (type) {
+      case filterType::gaussian: return 1.5;
+      case filterType::mitchell: return 2.0;
+      case filterType::blackmanHarris: return 1.5;
+      default: return 0.5;
+    }
+  }
+
+  /**
+   * Evaluate a filter shape directly
+   *
+   * @param type Filter shape
+   * @param x Distance from the pixel center, in [0, radius)
+   * @param radius Support radius of the filter
+   * @return Filter weight at x
+   */
+  static double evaluate(filterType type, double x, double radius) {
+    switch (type) {
+      case filterType::gaussian: {
+        // Shifted down so the weight reaches zero at the radius
+        const double sigma = 0.5;
+        auto g = [&](double t) { return std::exp(-t * t / (2 * sigma * sigma)); };
+        return g(x) - g(radius);
+      }
+      case filterType::mitchell: {
+        // Mitchell-Netravali cubic, defined over [0, 2]
+        const double b = 1.0 / 3, c = 1.0 / 3;
+        double t = 2 * x / radius;
+        if (t < 1) {
+          return ((12 - 9 * b - 6 * c) * t * t * t + (-18 + 12 * b + 6 * c) * t * t +
+                  (6 - 2 * b)) / 6;
+        }
+        return ((-b - 6 * c) * t * t * t + (6 * b + 30 * c) * t * t +
+                (-12 * b - 48 * c) * t + (8 * b + 24 * c)) / 6;
+      }
+      case filterType::blackmanHarris: {
+        // Window over [-radius, radius], peaking at the center
+        double t = 2 * PI * (0.5 + x / (2 * radius));
+        return 0.35875 - 0.48829 * std::cos(t) + 0.14128 * std::cos(2 * t) -
+               0.01168 * std::cos(3 * t);
+      }
+      default:
+        return 1;
+    }
+  }
+};
+
+#endif
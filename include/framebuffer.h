@@ -0,0 +1,89 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <algorithm>
+#include <vector>
+
+#include "utils.h"
+
+/**
+ * Floating point image holding the rendered color of every pixel
+ * Optionally carries auxiliary feature buffers (AOVs) describing the first
+ * surface seen through each pixel, used to guide the denoiser
+ */
+class framebuffer {
+ public:
+  int width = 0;                // Image width in pixels
+  int height = 0;               // Image height in pixels
+  std::vector<color> pixels;    // Linear color of each pixel (row-major)
+
+  // Feature buffers, empty unless requested at construction
+  std::vector<color> albedo;    // First-hit surface albedo
+  std::vector<vec3> normal;     // First-hit shading normal
+  std::vector<double> depth;    // First-hit distance from the camera
+  std::vector<double> variance; // Estimated variance of the pixel's luminance (of the mean, not one sample)
+
+  // Constructors
+  framebuffer() {}  // Empty image
+  framebuffer(int width, int height, bool withFeatures = false)
+      : width(width), height(height), pixels(size()) {
+    if (withFeatures) {
+      albedo.resize(size());
+      normal.resize(size());
+      depth.resize(size());
+      variance.resize(size());
+    }
+  }
+
+  /**
+   * Resize the image and clear it to black, dropping any feature buffers
+   * Reuses the existing storage when it is large enough
+   *
+   * @param newWidth New image width in pixels
+   * @param newHeight New image height in pixels
+   */
+  void reset(int newWidth, int newHeight) {
+    width = newWidth;
+    height = newHeight;
+    pixels.assign(size(), color(0, 0, 0));
+    albedo.clear();
+    normal.clear();
+    depth.clear();
+    variance.clear();
+  }
+
+  /**
+   * Copy a rectangle of the image, including any feature buffers
+   *
+   * @param x0 Left column of the rectangle
+   * @param y0 Top row of the rectangle
+   * @param w Rectangle width in pixels
+   * @param h Rectangle height in pixels
+   * @return The rectangle as an image of its own
+   */
+  framebuffer cropped(int x0, int y0, int w, int h) const {
+    framebuffer out(w, h, hasFeatures());
+    for (int j = 0; j < h; j++) {
+      int from = index(x0, y0 + j), to = out.index(0, j);
+      std::copy_n(pixels.begin() + from, w, out.pixels.begin() + to);
+      if (hasFeatures()) {
+        std::copy_n(albedo.begin() + from, w, out.albedo.begin() + to);
+        std::copy_n(normal.begin() + from, w, out.normal.begin() + to);
+        std::copy_n(depth.begin() + from, w, out.depth.begin() + to);
+        std::copy_n(variance.begin() + from, w, out.variance.begin() + to);
+      }
+    }
+    return out;
+  }
+
+  // Total number of pixels
+  int size() const { return width * height; }
+
+  // Whether the feature buffers are present
+  bool hasFeatures() const { return !albedo.empty(); }
+
+  // Row-major index of pixel (i, j)
+  int index(int i, int j) const { return j * width + i; }
+};
+
+#endif
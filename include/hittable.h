@@ -3,18 +3,20 @@
 
 #include "utils.h"
 
-// Forward declaration to avoid circular dependency
-class material;
+class hittable;
 
 /**
  * Structure to record information about a ray-object intersection
- * Stores hit point, normal, material, and other intersection details
+ * Stores hit point, normal, material ID, and other intersection details
+ * During traversal only t and object are filled in; the remaining fields are
+ * computed once, for the closest hit, by hittable::hit()
  */
 class hitRecord {
  public:
+  const hittable* object;      // Primitive that produced the hit
   point3 p;                    // Intersection point
   vec3 normal;                 // Surface normal at intersection point
-  shared_ptr<material> mat;    // Material of the hit object
+  int mat;                     // Index of the hit object's material in the scene's material list
   double t;                    // Ray parameter at intersection
   bool frontFace;              // Whether the ray hit the front face or back face
 
@@ -43,14 +45,58 @@ class hittable {
   virtual ~hittable() = default;
 
   /**
-   * Determine if a ray intersects with this object
+   * Determine if a ray intersects with this object (closest-hit query)
+   * Traverses with intersect() and then builds the full surface interaction
+   * only for the closest primitive, instead of for every candidate hit
    * 
    * @param r The ray to test
    * @param rayT Interval of valid ray parameters to consider
    * @param rec Record to store hit information if intersection occurs
    * @return true if the ray hits the object, false otherwise
    */
-  virtual bool hit(const ray& r, interval rayT, hitRecord& rec) const = 0;
+  bool hit(const ray& r, interval rayT, hitRecord& rec) const {
+    if (!intersect(r, rayT, rec)) return false;
+    rec.object->surfaceInteraction(r, rec);
+    return true;
+  }
+
+  /**
+   * Find the closest intersection of a ray with this object
+   * Records only the ray parameter and the primitive hit (rec.t, rec.object);
+   * leaves rec untouched if there is no intersection
+   * 
+   * @param r The ray to test
+   * @param rayT Interval of valid ray parameters to consider
+   * @param rec Record to store the hit distance and primitive in
+   * @return true if the ray hits the object, false otherwise
+   */
+  virtual bool intersect(const ray& r, interval rayT, hitRecord& rec) const = 0;
+
+  /**
+   * Complete a hit record produced by intersect() on this primitive
+   * Fills in the hit point, normal, face orientation and material ID
+   * Aggregates never record themselves as the hit object, so they need not override this
+   * 
+   * @param r The ray that hit the primitive
+   * @param rec Record holding the hit distance, completed in place
+   */
+  virtual void surfaceInteraction(const ray& /*r*/, hitRecord& /*rec*/) const {}
+
+  /**
+   * Determine if anything blocks a ray within an interval (any-hit query)
+   * Used for visibility and shadow rays, which need no surface information,
+   * so implementations stop at the first intersection found and skip
+   * computing hit points, normals and materials
+   * 
+   * @param r The ray to test
+   * @param rayT Interval of valid ray parameters to consider
+   * @return true if the ray hits the object, false otherwise
+   */
+  virtual bool occluded(const ray& r, interval rayT) const {
+    // Fallback for objects without a dedicated any-hit test
+    hitRecord rec;
+    return intersect(r, rayT, rec);
+  }
 };
 
 #endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef HITTABLELIST_H
 #define HITTABLELIST_H
 
+#include <memory_resource>
 #include <vector>
 
 #include "hittable.h"
@@ -13,11 +14,13 @@
 class hittableList : public hittable {
  public:
   // Collection of objects in the scene
-  std::vector<shared_ptr<hittable>> objects;
+  std::pmr::vector<shared_ptr<hittable>> objects;
 
   // Constructors
   hittableList() {}  // Empty list
   hittableList(shared_ptr<hittable> obj) { add(obj); }  // List with a single object
+  explicit hittableList(std::pmr::memory_resource* resource)  // Empty list stored in an arena
+      : objects(resource) {}
 
   // Clear all objects from the list
   void clear() { objects.clear(); }
@@ -26,32 +29,45 @@ class hittableList : public hittable {
   void add(shared_ptr<hittable> obj) { objects.push_back(obj); }
 
   /**
-   * Determine if a ray hits any object in the list
-   * If multiple objects are hit, returns the closest hit to the ray origin
+   * Find the closest intersection with any object in the list
+   * Each hit shrinks the interval, so later objects only report closer hits
    * 
    * @param r The ray to test
    * @param rayT Interval of valid ray parameters to consider
-   * @param rec Record to store hit information for the closest hit
+   * @param rec Record to store the closest hit distance and primitive in
    * @return true if any object is hit, false otherwise
    */
-  bool hit(const ray& r, interval rayT,
-           hitRecord& rec) const override {
-    hitRecord tempRec;
+  bool intersect(const ray& r, interval rayT,
+                 hitRecord& rec) const override {
     bool hitAnything = false;
     auto closestSoFar = rayT.max;  // Track distance to closest hit so far
 
     // Check each object for intersection
     for (const auto& obj : objects) {
       // Only consider hits closer than the closest hit so far
-      if (obj->hit(r, interval(rayT.min, closestSoFar), tempRec)) {
+      if (obj->intersect(r, interval(rayT.min, closestSoFar), rec)) {
         hitAnything = true;
-        closestSoFar = tempRec.t;  // Update closest hit distance
-        rec = tempRec;             // Save this hit as the current best
+        closestSoFar = rec.t;  // Update closest hit distance
       }
     }
     
     return hitAnything;
   }
+
+  /**
+   * Determine if any object in the list blocks a ray
+   * Returns as soon as one object reports an intersection
+   * 
+   * @param r The ray to test
+   * @param rayT Interval of valid ray parameters to consider
+   * @return true if any object is hit, false otherwise
+   */
+  bool occluded(const ray& r, interval rayT) const override {
+    for (const auto& obj : objects) {
+      if (obj->occluded(r, rayT)) return true;
+    }
+    return false;
+  }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,241 @@
+#ifndef IMAGEIO_H
+#define IMAGEIO_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "framebuffer.h"
+#include "toneMapper.h"
+
+/**
+ * Write 8-bit display values to an output stream in PPM format
+ * Outputs in PPM format, which consists of:
+ * - P3 header (indicates ASCII PPM format)
+ * - Image dimensions
+ * - Max color value (255)
+ * - Followed by RGB triplets for each pixel
+ *
+ * @param out Output stream to write to
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @param bytes 3 bytes (R, G, B) per pixel in row-major order
+ */
+inline void writeImageBytes(std::ostream& out, int width, int height,
+                            const std::vector<unsigned char>& bytes) {
+  out << "P3\n" << width << " " << height << "\n255\n";
+  for (int p = 0; p < width * height; p++) {
+    out << static_cast<int>(bytes[3 * p]) << ' '
+        << static_cast<int>(bytes[3 * p + 1]) << ' '
+        << static_cast<int>(bytes[3 * p + 2]) << '\n';
+  }
+}
+
+/**
+ * Write the color buffer of an image to an output stream in PPM format (P3)
+ *
+ * @param out Output stream to write to
+ * @param fb Image to write
+ * @param tones Color pipeline converting the image to display values
+ */
+inline void writeImage(std::ostream& out, const framebuffer& fb,
+                       const toneMapper& tones = toneMapper()) {
+  std::vector<unsigned char> bytes;
+  tones.apply(fb, bytes);
+  writeImageBytes(out, fb.width, fb.height, bytes);
+}
+
+/**
+ * Read an 8-bit PPM image, in ASCII (P3) or binary (P6) form
+ * Reads the images written by writeImage() and writeImageBinary()
+ *
+ * @param path File to read
+ * @param width Receives the image width in pixels
+ * @param height Receives the image height in pixels
+ * @param bytes Receives 3 bytes (R, G, B) per pixel in row-major order
+ * @return true if the file was read
+ */
+inline bool readImageBytes(const std::string& path, int& width, int& height,
+                           std::vector<unsigned char>& bytes) {
+  std::ifstream in(path, std::ios::binary);
+  std::string magic;
+  int maxValue = 0;
+  if (!(in >> magic >> width >> height >> maxValue) || (magic != "P3" && magic != "P6") ||
+      width <= 0 || height <= 0 || maxValue != 255) {
+    std::cerr << "Unable to read " << path << " as an 8-bit PPM image\n";
+    return false;
+  }
+
+  bytes.resize(3 * width * height);
+  if (magic == "P6") {
+    in.get();  // Single whitespace character ending the header
+    in.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+  } else {
+    int value = 0;
+    for (auto& b : bytes) {
+      if (!(in >> value)) break;
+      b = static_cast<unsigned char>(value);
+    }
+  }
+
+  if (!in) {
+    std::cerr << "Unexpected end of " << path << "\n";
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Write the color buffer of an image to an output stream in binary PPM format
+ * Uses the P6 variant (raw bytes) so frames are cheap to stream to a viewer
+ *
+ * @param out Output stream to write to
+ * @param fb Image to write
+ * @param bytes Buffer for the display values, reused across frames to avoid reallocating
+ * @param scale Factor applied to every pixel first, e.g. 1/passes for accumulation buffers
+ * @param tones Color pipeline converting the image to display values
+ */
+inline void writeImageBinary(std::ostream& out, const framebuffer& fb,
+                             std::vector<unsigned char>& bytes, double scale = 1.0,
+                             const toneMapper& tones = toneMapper()) {
+  tones.apply(fb, bytes, scale);
+
+  out << "P6\n" << fb.width << " " << fb.height << "\n255\n";
+  out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+/**
+ * Write the color buffer of an image to an output stream in binary PPM format
+ *
+ * @param out Output stream to write to
+ * @param fb Image to write
+ * @param scale Factor applied to every pixel first, e.g. 1/passes for accumulation buffers
+ * @param tones Color pipeline converting the image to display values
+ */
+inline void writeImageBinary(std::ostream& out, const framebuffer& fb,
+                             double scale = 1.0,
+                             const toneMapper& tones = toneMapper()) {
+  std::vector<unsigned char> bytes;
+  writeImageBinary(out, fb, bytes, scale, tones);
+}
+
+/**
+ * Write the color buffer of an image, untouched, to a Portable Float Map file
+ * PFM keeps the full linear HDR range, so the image can later be re-exposed
+ * and tone-mapped with readImageHDR() without rendering it again
+ *
+ * @param path File to write
+ * @param fb Image to write
+ * @return true if the file was written
+ */
+inline bool writeImageHDR(const std::string& path, const framebuffer& fb) {
+  std::ofstream out(path, std::ios::binary);
+  if (!out) {
+    std::cerr << "Unable to open " << path << " for writing\n";
+    return false;
+  }
+
+  // A negative scale marks little-endian data; rows are stored bottom to top
+  out << "PF\n" << fb.width << " " << fb.height << "\n-1.0\n";
+  std::vector<float> row(3 * fb.width);
+  for (int j = fb.height - 1; j >= 0; j--) {
+    for (int i = 0; i < fb.width; i++) {
+      for (int c = 0; c < 3; c++) {
+        row[3 * i + c] = static_cast<float>(fb.pixels[fb.index(i, j)][c]);
+      }
+    }
+    out.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(float));
+  }
+  return static_cast<bool>(out);
+}
+
+/**
+ * Read an image written by writeImageHDR()
+ * Only little-endian color PFM files are supported
+ *
+ * @param path File to read
+ * @param fb Receives the image (without feature buffers)
+ * @return true if the file was read
+ */
+inline bool readImageHDR(const std::string& path, framebuffer& fb) {
+  std::ifstream in(path, std::ios::binary);
+  std::string magic;
+  int width = 0, height = 0;
+  double endianScale = 0;
+  if (!(in >> magic >> width >> height >> endianScale) || magic != "PF" ||
+      width <= 0 || height <= 0 || endianScale >= 0) {
+    std::cerr << "Unable to read " << path << " as a little-endian color PFM\n";
+    return false;
+  }
+  in.get();  // Single whitespace character ending the header
+
+  fb.reset(width, height);
+  std::vector<float> row(3 * width);
+  for (int j = height - 1; j >= 0; j--) {
+    if (!in.read(reinterpret_cast<char*>(row.data()), row.size() * sizeof(float))) {
+      std::cerr << "Unexpected end of " << path << "\n";
+      return false;
+    }
+    for (int i = 0; i < width; i++) {
+      fb.pixels[fb.index(i, j)] = color(row[3 * i], row[3 * i + 1], row[3 * i + 2]);
+    }
+  }
+  return true;
+}
+
+/**
+ * Write a buffer of values already in [0,1] to a PPM file without gamma correction
+ * Used for feature buffers, which are data rather than colors to be displayed
+ *
+ * @param path File to write
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @param values Row-major RGB values to write
+ */
+inline void writeLinearImage(const std::string& path, int width, int height,
+                             const std::vector<vec3>& values) {
+  std::ofstream out(path);
+  if (!out) {
+    std::cerr << "Unable to open " << path << " for writing\n";
+    return;
+  }
+
+  static const interval intensity(0.000, 0.999);
+  out << "P3\n" << width << " " << height << "\n255\n";
+  for (const auto& v : values) {
+    out << static_cast<int>(255.999 * intensity.clamp(v.x())) << ' '
+        << static_cast<int>(255.999 * intensity.clamp(v.y())) << ' '
+        << static_cast<int>(255.999 * intensity.clamp(v.z())) << '\n';
+  }
+}
+
+/**
+ * Write the albedo, normal and depth feature buffers of an image as PPM files
+ * Files are named <prefix>albedo.ppm, <prefix>normal.ppm and <prefix>depth.ppm
+ * Normals are remapped from [-1,1] to [0,1]; depth is normalized by its maximum
+ *
+ * @param prefix Path prefix for the three output files
+ * @param fb Image carrying feature buffers
+ */
+inline void writeFeatureImages(const std::string& prefix, const framebuffer& fb) {
+  if (!fb.hasFeatures()) return;
+
+  writeLinearImage(prefix + "albedo.ppm", fb.width, fb.height, fb.albedo);
+
+  std::vector<vec3> remapped(fb.size());
+  for (int p = 0; p < fb.size(); p++) {
+    remapped[p] = 0.5 * (fb.normal[p] + vec3(1, 1, 1));
+  }
+  writeLinearImage(prefix + "normal.ppm", fb.width, fb.height, remapped);
+
+  double maxDepth = 0;
+  for (double d : fb.depth) maxDepth = std::fmax(maxDepth, d);
+  double scale = maxDepth > 0 ? 1.0 / maxDepth : 0.0;
+  for (int p = 0; p < fb.size(); p++) {
+    double d = fb.depth[p] * scale;
+    remapped[p] = vec3(d, d, d);
+  }
+  writeLinearImage(prefix + "depth.ppm", fb.width, fb.height, remapped);
+}
+
+#endif
@@ -0,0 +1,242 @@
+#ifndef IMAGEMETRICS_H
+#define IMAGEMETRICS_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "framebuffer.h"
+
+/**
+ * Error metrics between a reference image and a test image
+ * Both images hold display-encoded sRGB values in [0,1], as decoded from
+ * 8-bit files, and must have the same dimensions
+ */
+
+/**
+ * Root-mean-square error over all pixels and channels
+ *
+ * @param reference Reference image
+ * @param test Image to compare
+ * @return RMSE in display units (0 for identical images)
+ */
+inline double imageRMSE(const framebuffer& reference, const framebuffer& test) {
+  double sumSquares = 0;
+  for (int p = 0; p < reference.size(); p++) {
+    vec3 d = reference.pixels[p] - test.pixels[p];
+    sumSquares += dot(d, d);
+  }
+  return std::sqrt(sumSquares / (3.0 * reference.size()));
+}
+
+/**
+ * Peak signal-to-noise ratio for a peak value of 1
+ *
+ * @param reference Reference image
+ * @param test Image to compare
+ * @return PSNR in decibels (infinite for identical images)
+ */
+inline double imagePSNR(const framebuffer& reference, const framebuffer& test) {
+  double rmse = imageRMSE(reference, test);
+  return rmse > 0 ? -20 * std::log10(rmse) : INF;
+}
+
+/**
+ * Convolve a single-channel image with a separable kernel, clamping at the edges
+ *
+ * @param values Row-major channel values, filtered in place
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @param kernelX Horizontal kernel of odd length, centered on its middle tap
+ * @param kernelY Vertical kernel of odd length, centered on its middle tap
+ */
+inline void convolveSeparable(std::vector<double>& values, int width, int height,
+                              const std::vector<double>& kernelX,
+                              const std::vector<double>& kernelY) {
+  std::vector<double> rows(values.size());
+  int rx = static_cast<int>(kernelX.size()) / 2, ry = static_cast<int>(kernelY.size()) / 2;
+  for (int j = 0; j < height; j++) {
+    for (int i = 0; i < width; i++) {
+      double sum = 0;
+      for (int k = -rx; k <= rx; k++) {
+        sum += kernelX[k + rx] * values[j * width + std::clamp(i + k, 0, width - 1)];
+      }
+      rows[j * width + i] = sum;
+    }
+  }
+  for (int j = 0; j < height; j++) {
+    for (int i = 0; i < width; i++) {
+      double sum = 0;
+      for (int k = -ry; k <= ry; k++) {
+        sum += kernelY[k + ry] * rows[std::clamp(j + k, 0, height - 1) * width + i];
+      }
+      values[j * width + i] = sum;
+    }
+  }
+}
+
+/**
+ * Sampled Gaussian or one of its derivatives, covering three standard deviations
+ * The smoothing kernel sums to one; derivative kernels have their positive and
+ * negative taps each normalized to sum to +1 and -1, as in FLIP
+ *
+ * @param sigma Standard deviation in pixels
+ * @param derivative 0 for the Gaussian, 1 or 2 for its derivatives
+ * @return Kernel taps, centered on the middle one
+ */
+inline std::vector<double> gaussianKernel(double sigma, int derivative = 0) {
+  int radius = std::max(1, static_cast<int>(std::ceil(3 * sigma)));
+  std::vector<double> taps(2 * radius + 1);
+  double positive = 0, negative = 0;
+  for (int k = -radius; k <= radius; k++) {
+    double g = std::exp(-k * k / (2 * sigma * sigma));
+    if (derivative == 1) g *= -k / (sigma * sigma);
+    if (derivative == 2) g *= k * k / (sigma * sigma * sigma * sigma) - 1 / (sigma * sigma);
+    taps[k + radius] = g;
+    (g > 0 ? positive : negative) += g;
+  }
+  for (double& t : taps) {
+    if (derivative == 0) t /= positive;
+    else t /= (t > 0 ? positive : -negative);
+  }
+  return taps;
+}
+
+/**
+ * Perceptual difference in the style of NVIDIA's FLIP (Andersson et al. 2020)
+ * A simplified version of the published metric: both images are filtered by
+ * single-Gaussian approximations of the contrast sensitivity functions in a
+ * linear opponent space, compared with the Hunt-adjusted HyAB color distance,
+ * and the result is amplified where edges or points differ. Like FLIP, the
+ * per-pixel error lies in [0,1]; values are comparable between runs of this
+ * harness but not with the reference FLIP implementation.
+ *
+ * @param reference Reference image
+ * @param test Image to compare
+ * @param pixelsPerDegree Viewing condition (67 is a 0.7 m view of a 24" 4K display)
+ * @return Mean per-pixel error in [0,1]
+ */
+inline double imageFLIP(const framebuffer& reference, const framebuffer& test,
+                        double pixelsPerDegree = 67) {
+  const int w = reference.width, h = reference.height, n = reference.size();
+
+  // sRGB to linear RGB, and linear RGB to and from CIE XYZ (D65)
+  auto toLinear = [](double v) {
+    return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+  };
+  auto toXYZ = [](const vec3& c) {
+    return vec3(0.4124564 * c[0] + 0.3575761 * c[1] + 0.1804375 * c[2],
+                0.2126729 * c[0] + 0.7151522 * c[1] + 0.0721750 * c[2],
+                0.0193339 * c[0] + 0.1191920 * c[1] + 0.9503041 * c[2]);
+  };
+  auto toRGB = [](const vec3& x) {
+    return vec3(3.2404542 * x[0] - 1.5371385 * x[1] - 0.4985314 * x[2],
+                -0.9692660 * x[0] + 1.8760108 * x[1] + 0.0415560 * x[2],
+                0.0556434 * x[0] - 0.2040259 * x[1] + 1.0572252 * x[2]);
+  };
+  const vec3 white = toXYZ(vec3(1, 1, 1));
+
+  // CIELAB with the Hunt adjustment (chroma scaled by lightness)
+  auto toHuntLab = [&](const vec3& rgb) {
+    vec3 x = toXYZ(rgb);
+    auto f = [](double t) {
+      return t > 0.008856 ? std::cbrt(t) : 7.787 * t + 16.0 / 116;
+    };
+    double fx = f(x[0] / white[0]), fy = f(x[1] / white[1]), fz = f(x[2] / white[2]);
+    double l = 116 * fy - 16;
+    return vec3(l, 0.01 * l * 500 * (fx - fy), 0.01 * l * 200 * (fy - fz));
+  };
+  auto hyab = [](const vec3& a, const vec3& b) {
+    vec3 d = a - b;
+    return std::fabs(d[0]) + std::sqrt(d[1] * d[1] + d[2] * d[2]);
+  };
+
+  // Largest color error, between green and blue, sets the scale of the error
+  const double maxError =
+      std::pow(hyab(toHuntLab(vec3(0, 1, 0)), toHuntLab(vec3(0, 0, 1))), 0.7);
+
+  // Filter each image in the linear opponent space YCxCz
+  auto colorFiltered = [&](const framebuffer& fb) {
+    std::vector<double> channels[3];
+    for (auto& c : channels) c.resize(n);
+    for (int p = 0; p < n; p++) {
+      const color& s = fb.pixels[p];
+      vec3 x = toXYZ(vec3(toLinear(s[0]), toLinear(s[1]), toLinear(s[2])));
+      double yr = x[1] / white[1];
+      channels[0][p] = 116 * yr - 16;
+      channels[1][p] = 500 * (x[0] / white[0] - yr);
+      channels[2][p] = 200 * (yr - x[2] / white[2]);
+    }
+
+    // Spread of each channel's contrast sensitivity, from degrees to pixels
+    const double spreadDegrees[3] = {0.0154, 0.0164, 0.0450};
+    for (int c = 0; c < 3; c++) {
+      auto kernel = gaussianKernel(spreadDegrees[c] * pixelsPerDegree);
+      convolveSeparable(channels[c], w, h, kernel, kernel);
+    }
+
+    std::vector<vec3> lab(n);
+    for (int p = 0; p < n; p++) {
+      double yr = (channels[0][p] + 16) / 116;
+      vec3 x((channels[1][p] / 500 + yr) * white[0], yr * white[1],
+             (yr - channels[2][p] / 200) * white[2]);
+      vec3 rgb = toRGB(x);
+      for (int c = 0; c < 3; c++) rgb[c] = std::clamp(rgb[c], 0.0, 1.0);
+      lab[p] = toHuntLab(rgb);
+    }
+    return lab;
+  };
+
+  // Edge and point responses of each image's normalized lightness
+  auto features = [&](const framebuffer& fb, std::vector<double>& edges,
+                      std::vector<double>& points) {
+    std::vector<double> lightness(n);
+    for (int p = 0; p < n; p++) {
+      const color& s = fb.pixels[p];
+      double y = toXYZ(vec3(toLinear(s[0]), toLinear(s[1]), toLinear(s[2])))[1] / white[1];
+      lightness[p] = (116 * std::cbrt(std::max(y, 0.0)) - 16) / 100;
+    }
+
+    double sigma = 0.5 * 0.082 * pixelsPerDegree;
+    auto g0 = gaussianKernel(sigma), g1 = gaussianKernel(sigma, 1), g2 = gaussianKernel(sigma, 2);
+    std::vector<double> ex = lightness, ey = lightness, px = lightness, py = lightness;
+    convolveSeparable(ex, w, h, g1, g0);
+    convolveSeparable(ey, w, h, g0, g1);
+    convolveSeparable(px, w, h, g2, g0);
+    convolveSeparable(py, w, h, g0, g2);
+
+    edges.resize(n);
+    points.resize(n);
+    for (int p = 0; p < n; p++) {
+      edges[p] = std::hypot(ex[p], ey[p]);
+      points[p] = std::hypot(px[p], py[p]);
+    }
+  };
+
+  std::vector<vec3> labReference = colorFiltered(reference), labTest = colorFiltered(test);
+  std::vector<double> edgesReference, pointsReference, edgesTest, pointsTest;
+  features(reference, edgesReference, pointsReference);
+  features(test, edgesTest, pointsTest);
+
+  const double pc = 0.4, pt = 0.95;  // Knee of the color error remapping
+  double total = 0;
+  for (int p = 0; p < n; p++) {
+    // Color error, compressed and remapped to [0,1]
+    double e = std::pow(hyab(labReference[p], labTest[p]), 0.7);
+    double colorError = e < pc * maxError
+                            ? pt * e / (pc * maxError)
+                            : pt + (e - pc * maxError) / (maxError - pc * maxError) * (1 - pt);
+    colorError = std::min(colorError, 1.0);
+
+    // Feature error, which raises the color error towards one
+    double featureError = std::sqrt(
+        std::max(std::fabs(edgesReference[p] - edgesTest[p]),
+                 std::fabs(pointsReference[p] - pointsTest[p])) / std::sqrt(2.0));
+    featureError = std::min(featureError, 1.0);
+
+    total += std::pow(colorError, 1 - featureError);
+  }
+  return total / n;
+}
+
+#endif
@@ -1,34 +1,18 @@
 #ifndef MATERIAL_H
 #define MATERIAL_H
 
-#include "hittable.h"
-
-/**
- * Abstract base class for all materials
- * Defines how light interacts with surfaces
- */
-class material {
- public:
-  virtual ~material() = default;
+#include <memory_resource>
+#include <variant>
+#include <vector>
 
-  /**
-   * Determine how a ray scatters when hitting a surface with this material
-   * 
-   * @param rIn Incident ray that hit the surface
-   * @param rec Hit record containing information about the intersection
-   * @param attenuation How much the light is attenuated by this scatter
-   * @param scattered The resulting scattered ray
-   * @return true if the ray is scattered, false if absorbed
-   */
-  virtual bool scatter(const ray& rIn, const hitRecord& rec, color& attenuation,
-                       ray& scattered) const = 0;
-};
+#include "hittable.h"
+#include "spectrum.h"
 
 /**
  * Lambertian (diffuse) material that scatters light randomly
  * Simulates matte surfaces like chalk or unfinished wood
  */
-class lambertian : public material {
+class lambertian {
  public:
   /**
    * Construct a lambertian material with given albedo (color reflectance)
@@ -40,7 +24,7 @@ class lambertian : public material {
    * Rays are scattered in random directions with cosine-weighted distribution
    */
   bool scatter(const ray& rIn, const hitRecord& rec, color& attenuation,
-               ray& scattered) const override {
+               ray& scattered) const {
     // Generate a random scatter direction
     auto scatterDir = rec.normal + randomUnitVec3();
 
@@ -59,6 +43,12 @@ class lambertian : public material {
     return true;
   }
 
+  // Albedo reported to the denoiser's feature buffer
+  color featureAlbedo() const { return albedo; }
+
+  // Diffuse surfaces end the denoiser's feature search
+  bool isSpecular() const { return false; }
+
  private:
   color albedo;  // Surface color/reflectance
 };
@@ -67,7 +57,7 @@ class lambertian : public material {
  * Metal material that reflects light according to law of reflection
  * Simulates polished metal surfaces with optional fuzziness
  */
-class metal : public material {
+class metal {
  public:
   /**
    * Construct a metal material
@@ -82,7 +72,7 @@ class metal : public material {
    * Rays are reflected with some randomness based on fuzziness
    */
   bool scatter(const ray& rIn, const hitRecord& rec, color& attenuation,
-               ray& scattered) const override {
+               ray& scattered) const {
     // Calculate reflection direction with added fuzziness
     auto scatterDir =
         reflect(rIn.direction(), rec.normal) + fuzz * randomUnitVec3();
@@ -97,6 +87,12 @@ class metal : public material {
     return (dot(scattered.direction(), rec.normal) > 0);
   }
 
+  // Albedo reported to the denoiser's feature buffer
+  color featureAlbedo() const { return albedo; }
+
+  // The denoiser looks through reflections for its albedo and normal
+  bool isSpecular() const { return true; }
+
  private:
   color albedo;  // Surface color/reflectance
   double fuzz;   // Reflection fuzziness factor
@@ -106,26 +102,73 @@ class metal : public material {
  * Dielectric material that both reflects and refracts light
  * Simulates transparent materials like glass, water, or diamonds
  */
-class dielectric : public material {
+class dielectric {
  public:
   /**
    * Construct a dielectric material
    * 
    * @param ir Index of refraction (air=1.0, glass≈1.5, diamond≈2.4)
+   * @param cauchyB Dispersion coefficient in µm² (0=none, crown glass≈0.0042),
+   *                only used by spectral rendering
    */
-  dielectric(double ir) : indexOfRefraction(ir) {}
+  dielectric(double ir, double cauchyB = 0) : indexOfRefraction(ir), cauchyB(cauchyB) {}
 
   /**
    * Scatter incoming ray with reflection or refraction
    * Uses Snell's Law and Fresnel equations to determine behavior
    */
   bool scatter(const ray& rIn, const hitRecord& rec, color& attenuation,
-               ray& scattered) const override {
+               ray& scattered) const {
     // Dielectrics don't absorb light (clear glass/water)
     attenuation = color(1.0, 1.0, 1.0);
-    
+    scattered = ray(rec.p, scatterDirection(rIn, rec, indexOfRefraction));
+    return true;
+  }
+
+  /**
+   * Spectral scatter with a wavelength-dependent index of refraction
+   * A dispersive surface bends each wavelength differently, so only the hero
+   * wavelength can follow the scattered ray and the others are terminated
+   */
+  bool scatter(const ray& rIn, const hitRecord& rec, sampledWavelengths& lambda,
+               sampledSpectrum& attenuation, ray& scattered) const {
+    attenuation = sampledSpectrum(1.0);
+    if (cauchyB != 0) lambda.terminateSecondary();
+    scattered = ray(rec.p, scatterDirection(rIn, rec, indexAt(lambda.lambda[0])));
+    return true;
+  }
+
+  // Clear glass reports white albedo to the denoiser
+  color featureAlbedo() const { return color(1, 1, 1); }
+
+  // The denoiser looks through refractions for its albedo and normal
+  bool isSpecular() const { return true; }
+
+ private:
+  double indexOfRefraction;  // Index of refraction of the material (at 589.3 nm)
+  double cauchyB;            // Cauchy dispersion coefficient in µm²
+
+  /**
+   * Index of refraction at a wavelength, from Cauchy's equation n = A + B/λ²
+   * A is chosen so the index equals indexOfRefraction at the sodium D line
+   */
+  double indexAt(double lambdaNm) const {
+    const double lambdaD = 0.5893;  // Sodium D line in µm
+    double lambdaUm = lambdaNm * 1e-3;
+    return indexOfRefraction + cauchyB * (1 / (lambdaUm * lambdaUm) - 1 / (lambdaD * lambdaD));
+  }
+
+  /**
+   * Choose between reflection and refraction for a given index of refraction
+   * 
+   * @param rIn Incident ray that hit the surface
+   * @param rec Hit record containing information about the intersection
+   * @param eta Index of refraction of the material
+   * @return Direction of the scattered ray
+   */
+  static vec3 scatterDirection(const ray& rIn, const hitRecord& rec, double eta) {
     // Determine relative index of refraction based on which side we're hitting
-    double ri = rec.frontFace ? (1.0/indexOfRefraction) : indexOfRefraction;
+    double ri = rec.frontFace ? (1.0/eta) : eta;
 
     // Get unit direction vector of incoming ray
     vec3 unitDir = unitVector(rIn.direction());
@@ -147,16 +190,9 @@ class dielectric : public material {
       dir = refract(unitDir, rec.normal, ri);
     }
     
-    // Create scattered ray
-    scattered = ray(rec.p, dir);
-    
-    // Dielectrics always scatter (reflection or refraction)
-    return true;
+    return dir;
   }
 
- private:
-  double indexOfRefraction;  // Index of refraction of the material
-
   /**
    * Calculate reflectance using Schlick's approximation for Fresnel equations
    * Determines what fraction of light is reflected vs refracted
@@ -169,4 +205,99 @@ class dielectric : public material {
   }
 };
 
+/**
+ * A material is a tagged union of every concrete material type
+ * Materials are stored by value, so a scene's materials sit in one contiguous
+ * table and scattering dispatches on the tag instead of through a vtable
+ *
+ * To add a material type, write a class with scatter(), featureAlbedo() and
+ * isSpecular() members like the ones above and append it to this list.
+ * A spectral scatter() overload is optional; see scatter() below.
+ */
+using material = std::variant<lambertian, metal, dielectric>;
+
+/**
+ * Determine how a ray scatters when hitting a surface with the given material
+ * 
+ * @param mat Material of the surface that was hit
+ * @param rIn Incident ray that hit the surface
+ * @param rec Hit record containing information about the intersection
+ * @param attenuation How much the light is attenuated by this scatter
+ * @param scattered The resulting scattered ray
+ * @return true if the ray is scattered, false if absorbed
+ */
+inline bool scatter(const material& mat, const ray& rIn, const hitRecord& rec,
+                    color& attenuation, ray& scattered) {
+  return std::visit(
+      [&](const auto& m) { return m.scatter(rIn, rec, attenuation, scattered); },
+      mat);
+}
+
+/**
+ * Spectral version of scatter() for the given wavelengths
+ * Materials whose behaviour depends on wavelength provide their own spectral
+ * scatter(); for the rest, the RGB attenuation is upsampled to a spectrum
+ * 
+ * @param mat Material of the surface that was hit
+ * @param rIn Incident ray that hit the surface
+ * @param rec Hit record containing information about the intersection
+ * @param lambda Wavelengths carried by the path (secondaries may be terminated)
+ * @param attenuation How much each wavelength is attenuated by this scatter
+ * @param scattered The resulting scattered ray
+ * @return true if the ray is scattered, false if absorbed
+ */
+inline bool scatter(const material& mat, const ray& rIn, const hitRecord& rec,
+                    sampledWavelengths& lambda, sampledSpectrum& attenuation,
+                    ray& scattered) {
+  return std::visit(
+      [&](const auto& m) {
+        if constexpr (requires { m.scatter(rIn, rec, lambda, attenuation, scattered); }) {
+          return m.scatter(rIn, rec, lambda, attenuation, scattered);
+        } else {
+          color rgb;
+          bool scatters = m.scatter(rIn, rec, rgb, scattered);
+          attenuation = rgbToSpectrum(rgb, lambda);
+          return scatters;
+        }
+      },
+      mat);
+}
+
+// Albedo of a material as reported to the denoiser's feature buffer
+inline color featureAlbedo(const material& mat) {
+  return std::visit([](const auto& m) { return m.featureAlbedo(); }, mat);
+}
+
+// Whether the denoiser should look through a material for its features
+inline bool isSpecular(const material& mat) {
+  return std::visit([](const auto& m) { return m.isSpecular(); }, mat);
+}
+
+/**
+ * Contiguous table of all materials in a scene
+ * Primitives refer to their material by its index in this table
+ */
+class materialList {
+ public:
+  // Materials in the scene, indexed by material ID
+  std::pmr::vector<material> materials;
+
+  // Constructors
+  materialList() {}  // Empty table
+  explicit materialList(std::pmr::memory_resource* resource)  // Empty table stored in an arena
+      : materials(resource) {}
+
+  // Clear all materials from the list
+  void clear() { materials.clear(); }
+
+  // Add a material to the list and return its ID
+  int add(const material& mat) {
+    materials.push_back(mat);
+    return static_cast<int>(materials.size()) - 1;
+  }
+
+  // Look up a material by its ID
+  const material& operator[](int id) const { return materials[id]; }
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,149 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Number of worker threads used by parallel loops
+ * Falls back to a single thread when the hardware concurrency is unknown
+ */
+inline int workerCount() {
+  return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+/**
+ * Fixed set of worker threads shared by all parallel loops
+ * Threads are started once and parked between loops, so running a loop
+ * performs no heap allocation and no thread creation
+ */
+class threadPool {
+ public:
+  // The process-wide pool, started on first use
+  static threadPool& instance() {
+    static threadPool pool(workerCount() - 1);
+    return pool;
+  }
+
+  /**
+   * Run fn(i) for every i in [begin, end) on the workers and the calling thread
+   * Indices are handed out one at a time so uneven rows balance across workers
+   * Calls made from inside a loop body run serially on the calling worker
+   *
+   * @param begin First index (inclusive)
+   * @param end Last index (exclusive)
+   * @param fn Callable invoked once per index
+   */
+  template <typename F>
+  void run(int begin, int end, F& fn) {
+    if (insideWorker || threads.empty()) {
+      for (int i = begin; i < end; i++) fn(i);
+      return;
+    }
+
+    // One loop at a time; concurrent callers wait their turn
+    std::lock_guard<std::mutex> runLock(runMutex);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      task = [](void* ctx, int i) { (*static_cast<F*>(ctx))(i); };
+      context = &fn;
+      next = begin;
+      last = end;
+      busy = static_cast<int>(threads.size());
+      generation++;
+    }
+    wakeup.notify_all();
+
+    work();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return busy == 0; });
+  }
+
+  /**
+   * Index of the calling thread within the current loop
+   * Workers are numbered 1..size()-1; any other thread (the loop's caller) is 0
+   */
+  static int threadIndex() { return workerId; }
+
+  // Number of threads that run a loop, including the caller
+  int size() const { return static_cast<int>(threads.size()) + 1; }
+
+  ~threadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wakeup.notify_all();
+    for (auto& t : threads) t.join();
+  }
+
+ private:
+  std::vector<std::thread> threads;  // Parked worker threads
+  std::mutex runMutex;               // Serializes loops from different callers
+  std::mutex mutex;                  // Guards the loop description below
+  std::condition_variable wakeup;    // Signals workers that a loop is ready
+  std::condition_variable finished;  // Signals the caller that workers are done
+
+  void (*task)(void*, int) = nullptr;  // Type-erased loop body
+  void* context = nullptr;             // Loop body object passed to task
+  std::atomic<int> next{0};            // Next index to hand out
+  int last = 0;                        // One past the final index
+  int busy = 0;                        // Workers still running the current loop
+  unsigned generation = 0;             // Incremented for every new loop
+  bool stopping = false;               // Set when the pool shuts down
+
+  static inline thread_local bool insideWorker = false;  // Whether this thread is a loop worker
+  static inline thread_local int workerId = 0;           // This thread's index, see threadIndex()
+
+  explicit threadPool(int workers) {
+    for (int t = 0; t < workers; t++) threads.emplace_back(&threadPool::workerLoop, this, t + 1);
+  }
+
+  // Claim and run indices of the current loop until none are left
+  void work() {
+    bool wasInside = insideWorker;
+    insideWorker = true;
+    for (int i = next++; i < last; i = next++) task(context, i);
+    insideWorker = wasInside;
+  }
+
+  // Body of each worker thread: wait for a loop, help run it, repeat
+  void workerLoop(int id) {
+    workerId = id;
+    unsigned seen = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wakeup.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+      }
+
+      work();
+
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--busy == 0) finished.notify_one();
+    }
+  }
+};
+
+/**
+ * Run fn(i) for every i in [begin, end) across all hardware threads
+ * Indices are handed out one at a time so uneven rows balance across workers
+ *
+ * @param begin First index (inclusive)
+ * @param end Last index (exclusive)
+ * @param fn Callable invoked once per index
+ */
+template <typename F>
+void parallelFor(int begin, int end, F&& fn) {
+  threadPool::instance().run(begin, end, fn);
+}
+
+#endif
@@ -0,0 +1,257 @@
+#ifndef PREVIEWSERVER_H
+#define PREVIEWSERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "camera.h"
+#include "hittable.h"
+#include "imageIO.h"
+#include "material.h"
+
+/**
+ * Long-running interactive renderer
+ * Keeps the scene resident, reads camera changes from an input stream and
+ * streams progressively refined frames to an output stream as binary PPMs
+ * (viewable with e.g. `ffplay -f image2pipe -vcodec ppm -`)
+ *
+ * Commands, one per line:
+ *   vfov <degrees>
+ *   lookfrom <x> <y> <z>
+ *   lookat <x> <y> <z>
+ *   vup <x> <y> <z>
+ *   defocus <angle>
+ *   focus <distance>
+ *   width <pixels>
+ *   spp <samples>       Stop refining after this many samples per pixel
+ *   quit
+ *
+ * Commands that would leave the camera without a view (lookfrom equal to
+ * lookat, vup along the view direction, a focus distance that is not
+ * positive) are rejected and leave the settings unchanged
+ *
+ * Every camera change cancels the frame in flight, sends coarse-to-fine
+ * preview frames (one ray per 8x8 block, refined tile by tile through 4x4,
+ * 2x2 and 1x1) and then continues with full-resolution accumulation
+ *
+ * Setting a region of interest refines the tiles around it first, so they
+ * reach full resolution while distant tiles are still coarse:
+ *   roi <x> <y>         Fractions of the image width and height
+ *   roi off
+ */
+class previewServer {
+ public:
+  int maxSamples = 500;    // Stop refining once this many samples per pixel are accumulated
+
+  /**
+   * Construct a server for a scene
+   *
+   * @param cam Initial camera settings
+   * @param world The collection of objects in the scene
+   * @param materials The materials referenced by objects in the scene
+   */
+  previewServer(const camera& cam, const hittable& world,
+                const materialList& materials)
+      : pending(cam), world(world), materials(materials) {}
+
+  /**
+   * Serve until a quit command or the end of the command stream
+   *
+   * @param in Stream to read commands from
+   * @param out Stream to write frames to
+   */
+  void run(std::istream& in, std::ostream& out) {
+    dirty = true;
+    quit = false;
+    std::thread reader(&previewServer::readCommands, this, std::ref(in));
+
+    camera active;
+    framebuffer accum;
+    int passes = 0;
+    int limit = maxSamples;  // maxSamples as of the last wakeup, read under the lock
+    auto changeTime = std::chrono::steady_clock::now();
+
+    while (true) {
+      {
+        // Sleep once the image has converged until a command arrives
+        std::unique_lock<std::mutex> lock(mutex);
+        wakeup.wait(lock, [&] { return quit || dirty || passes < maxSamples; });
+        if (quit) break;
+        limit = maxSamples;
+
+        if (dirty) {
+          active = pending;
+          dirty = false;
+          passes = 0;
+          changeTime = std::chrono::steady_clock::now();
+        }
+      }
+
+      if (passes == 0) {
+        // Coarse levels give a recognizable full frame as soon as possible,
+        // and the finished preview doubles as the first accumulation pass
+        auto onFrame = [&](const framebuffer &fb, int block) {
+          emit(out, fb, 1, active.toneMapping, changeTime, block);
+        };
+        if (!active.renderCoarseToFine(world, materials, accum, onFrame, &dirty)) continue;
+        passes = 1;
+        continue;
+      }
+
+      if (!active.accumulatePass(world, materials, accum, &dirty)) continue;
+      passes++;
+
+      // Doubling the interval between frames keeps output bandwidth bounded
+      if ((passes & (passes - 1)) == 0 || passes == limit) {
+        emit(out, accum, passes, active.toneMapping, changeTime);
+      }
+    }
+
+    reader.join();
+  }
+
+  /**
+   * Write an averaged frame and report its latency since the last change
+   * Called from run() for every frame sent; reuses one byte buffer, so
+   * streaming frames does not allocate once the image size is settled
+   *
+   * @param out Stream to write the frame to
+   * @param accum Accumulation buffer holding per-pixel sums
+   * @param passes Number of samples accumulated per pixel
+   * @param tones Color pipeline converting the frame to display values
+   * @param changeTime When the camera settings last changed
+   * @param block Largest block size left in a preview frame
+   */
+  void emit(std::ostream& out, const framebuffer& accum, int passes,
+            const toneMapper& tones,
+            std::chrono::steady_clock::time_point changeTime, int block = 1) {
+    writeImageBinary(out, accum, frameBytes, 1.0 / passes, tones);
+    out.flush();
+
+    auto elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - changeTime);
+    std::clog << "Frame " << accum.width << "x" << accum.height << " at "
+              << passes << " spp";
+    if (block > 1) std::clog << " (blocks up to " << block << "x" << block << ")";
+    std::clog << ", " << elapsed.count() << " ms after change" << std::endl;
+  }
+
+ private:
+  camera pending;                  // Latest camera settings received
+  const hittable& world;           // Scene being rendered
+  const materialList& materials;   // Materials referenced by the scene
+
+  std::mutex mutex;                // Guards pending, maxSamples and quit
+  std::condition_variable wakeup;  // Signalled when a command arrives
+  std::atomic<bool> dirty;         // Camera changed since the current render started
+  bool quit = false;               // Set when the command stream ends
+  std::vector<unsigned char> frameBytes;  // Display values of the frame being sent
+
+  /**
+   * Read commands until quit or end of stream, updating the pending camera
+   *
+   * @param in Stream to read commands from
+   */
+  void readCommands(std::istream& in) {
+    std::string line;
+    while (std::getline(in, line)) {
+      if (line == "quit") break;
+      if (line.empty()) continue;
+
+      std::lock_guard<std::mutex> lock(mutex);
+      bool restart = false;
+      if (applyCommand(line, restart)) {
+        if (restart) dirty = true;
+        wakeup.notify_one();
+      } else {
+        std::cerr << "Invalid command: " << line << "\n";
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    quit = true;
+    dirty = true;  // Cancels the frame in flight
+    wakeup.notify_one();
+  }
+
+  /**
+   * Apply a single command line to the pending camera or server settings
+   * Arguments are parsed and validated first, so a malformed command, or one
+   * that would leave the camera without a valid view (NaN pixels), changes nothing
+   *
+   * @param line Command to parse
+   * @param restart Set to true if the camera changed and accumulation must start over
+   * @return true if the command was recognized and well-formed
+   */
+  bool applyCommand(const std::string& line, bool& restart) {
+    std::istringstream args(line);
+    std::string cmd;
+    args >> cmd;
+    restart = true;
+
+    double x, y, z;
+    int n;
+    if (cmd == "vfov" && args >> x && x > 0 && x < 180) {
+      pending.vfov = x;
+    } else if (cmd == "lookfrom" && args >> x >> y >> z &&
+               validBasis(point3(x, y, z), pending.lookAt, pending.vup)) {
+      pending.lookFrom = point3(x, y, z);
+    } else if (cmd == "lookat" && args >> x >> y >> z &&
+               validBasis(pending.lookFrom, point3(x, y, z), pending.vup)) {
+      pending.lookAt = point3(x, y, z);
+    } else if (cmd == "vup" && args >> x >> y >> z &&
+               validBasis(pending.lookFrom, pending.lookAt, vec3(x, y, z))) {
+      pending.vup = vec3(x, y, z);
+    } else if (cmd == "defocus" && args >> x && x >= 0 && x < 180) {
+      pending.defocusAngle = x;
+    } else if (cmd == "focus" && args >> x && x > 0) {
+      pending.focusDist = x;
+    } else if (cmd == "width" && args >> n && n > 0) {
+      pending.imageWidth = n;
+    } else if (cmd == "spp" && args >> n && n > 0) {
+      // The samples accumulated so far stay valid; refinement just resumes or stops
+      maxSamples = n;
+      restart = false;
+    } else if (cmd == "roi") {
+      std::string arg;
+      args >> arg;
+      std::istringstream first(arg);
+      if (arg == "off") {
+        pending.useRegionOfInterest = false;
+      } else if (first >> x && args >> y) {
+        pending.roiX = x;
+        pending.roiY = y;
+        pending.useRegionOfInterest = true;
+      } else {
+        return false;
+      }
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Check that camera settings define an orientation
+   * The view direction must be nonzero and not parallel to the up vector,
+   * otherwise the camera basis and every traced ray become NaN
+   *
+   * @param lookFrom Camera position
+   * @param lookAt Point the camera looks at
+   * @param vup Camera-relative up direction
+   * @return true if the camera basis is well defined
+   */
+  static bool validBasis(const point3& lookFrom, const point3& lookAt, const vec3& vup) {
+    vec3 view = lookFrom - lookAt;
+    if (view.nearZero()) return false;
+    return !cross(vup, unitVector(view)).nearZero();
+  }
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef SCENES_H
+#define SCENES_H
+
+#include "arena.h"
+#include "camera.h"
+#include "hittableList.h"
+#include "material.h"
+#include "sphere.h"
+#include "staticScene.h"
+
+// Compile-time specialized scene type for scenes made only of spheres
+using sphereScene = staticScene<sphere>;
+
+/**
+ * Build the example scene: a field of small random spheres around three
+ * large feature spheres (glass, diffuse and metal) on a grey ground sphere
+ *
+ * @param world Collection that receives the spheres
+ * @param materials Table that receives the spheres' materials
+ * @param sceneArena Arena the spheres are allocated in; must outlive world
+ */
+inline void randomSpheresScene(hittableList& world, materialList& materials,
+                               arena& sceneArena) {
+  // Add a large sphere as the ground
+  auto groundMaterial = materials.add(lambertian(color(0.5, 0.5, 0.5)));
+  world.add(sceneArena.make<sphere>(point3(0, -1000, 0), 1000, groundMaterial));
+
+  // Generate a random scene with many small spheres
+  for (int a = -11; a < 11; a++) {
+    for (int b = -11; b < 11; b++) {
+      // Choose a random material type
+      auto chooseMat = randomDouble();
+      
+      // Create a random center point with small random offset
+      point3 center(a + 0.9 * randomDouble(), 0.2, b + 0.9 * randomDouble());
+
+      // Ensure spheres aren't too close to the large spheres we'll add later
+      if ((center - point3(4, 0.2, 0)).length() > 0.9) {
+        int sphereMaterial;
+
+        if (chooseMat < 0.8) {
+          // Diffuse material (80% chance)
+          auto albedo = vec3::random() * vec3::random();  // Random color with gamma correction
+          sphereMaterial = materials.add(lambertian(albedo));
+          world.add(sceneArena.make<sphere>(center, 0.2, sphereMaterial));
+        } else if (chooseMat < 0.95) {
+          // Metal material (15% chance)
+          auto albedo = vec3::random(0.5, 1);  // Metallic colors tend to be lighter
+          auto fuzz = randomDouble(0, 0.5);    // Random fuzziness/roughness
+          sphereMaterial = materials.add(metal(albedo, fuzz));
+          world.add(sceneArena.make<sphere>(center, 0.2, sphereMaterial));
+        } else {
+          // Glass material (5% chance)
+          sphereMaterial = materials.add(dielectric(1.5, 0.0042));  // Crown glass (disperses in spectral mode)
+          world.add(sceneArena.make<sphere>(center, 0.2, sphereMaterial));
+        }
+      }
+    }
+  }
+
+  // Add three large spheres as focal points of the scene
+  
+  // Large glass sphere in the center
+  auto material1 = materials.add(dielectric(1.5, 0.0042));
+  world.add(sceneArena.make<sphere>(point3(0, 1, 0), 1.0, material1));
+
+  // Large diffuse sphere to the left
+  auto material2 = materials.add(lambertian(color(0.4, 0.2, 0.1)));  // Brown
+  world.add(sceneArena.make<sphere>(point3(-4, 1, 0), 1.0, material2));
+
+  // Large metal sphere to the right
+  auto material3 = materials.add(metal(color(0.7, 0.6, 0.5), 0.0));  // Polished gold
+  world.add(sceneArena.make<sphere>(point3(4, 1, 0), 1.0, material3));
+}
+
+/**
+ * Camera for small renders of the example scene, as used by the benchmarks
+ * and the regression harness
+ * Views the scene from the same position as the full render, with a shallow
+ * bounce limit and no defocus blur
+ *
+ * @param width Image width in pixels
+ * @param samplesPerPixel Number of random samples per pixel
+ * @return The configured camera
+ */
+inline camera exampleCamera(int width, int samplesPerPixel) {
+  camera cam;
+  cam.imageWidth = width;
+  cam.samplesPerPixel = samplesPerPixel;
+  cam.maxDepth = 10;
+  cam.vfov = 20;
+  cam.lookFrom = point3(13, 2, 3);
+  cam.lookAt = point3(0, 0, 0);
+  return cam;
+}
+
+#endif
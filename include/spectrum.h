@@ -0,0 +1,217 @@
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <algorithm>
+
+#include "utils.h"
+
+// Range of wavelengths (in nanometres) traced by the spectral renderer
+const double LAMBDA_MIN = 380.0;
+const double LAMBDA_MAX = 730.0;
+
+// Number of wavelengths carried by each path (one hero plus its companions)
+const int SPECTRUM_SAMPLES = 4;
+
+/**
+ * Radiance or reflectance at each of a path's wavelengths
+ * The fixed-size lane loops compile to SIMD instructions, so a path carries
+ * all of its wavelengths for roughly the cost of one RGB color
+ */
+class sampledSpectrum {
+ public:
+  double v[SPECTRUM_SAMPLES];  // Value at each wavelength
+
+  // Constructors
+  sampledSpectrum() : sampledSpectrum(0.0) {}  // Zero at every wavelength
+  explicit sampledSpectrum(double c) {         // Constant at every wavelength
+    for (int i = 0; i < SPECTRUM_SAMPLES; i++) v[i] = c;
+  }
+
+  double operator[](int i) const { return v[i]; }
+  double& operator[](int i) { return v[i]; }
+
+  // Compound assignment operators
+  sampledSpectrum& operator+=(const sampledSpectrum& s) {
+    for (int i = 0; i < SPECTRUM_SAMPLES; i++) v[i] += s.v[i];
+    return *this;
+  }
+
+  sampledSpectrum& operator*=(const sampledSpectrum& s) {
+    for (int i = 0; i < SPECTRUM_SAMPLES; i++) v[i] *= s.v[i];
+    return *this;
+  }
+
+  sampledSpectrum& operator*=(double t) {
+    for (int i = 0; i < SPECTRUM_SAMPLES; i++) v[i] *= t;
+    return *this;
+  }
+};
+
+// Lane-wise spectrum multiplication
+inline sampledSpectrum operator*(sampledSpectrum a, const sampledSpectrum& b) {
+  return a *= b;
+}
+
+// Spectrum-scalar multiplication
+inline sampledSpectrum operator*(double t, sampledSpectrum s) { return s *= t; }
+
+// Spectrum addition
+inline sampledSpectrum operator+(sampledSpectrum a, const sampledSpectrum& b) {
+  return a += b;
+}
+
+/**
+ * The wavelengths carried by a path and the probability of having chosen them
+ * Hero wavelength sampling: lane 0 is chosen uniformly at random and the other
+ * lanes are spaced evenly after it (wrapping around the visible range), so
+ * together they cover the spectrum while needing only one random number
+ */
+class sampledWavelengths {
+ public:
+  double lambda[SPECTRUM_SAMPLES];  // Wavelength of each lane in nanometres
+  double pdf[SPECTRUM_SAMPLES];     // Sampling density of each lane (0 once terminated)
+
+  /**
+   * Choose a hero wavelength and its evenly spaced companions
+   *
+   * @param u Uniform random number in [0,1)
+   * @return The sampled wavelengths
+   */
+  static sampledWavelengths sampleUniform(double u) {
+    sampledWavelengths w;
+    const double range = LAMBDA_MAX - LAMBDA_MIN;
+    w.lambda[0] = LAMBDA_MIN + u * range;
+
+    const double delta = range / SPECTRUM_SAMPLES;
+    for (int i = 1; i < SPECTRUM_SAMPLES; i++) {
+      w.lambda[i] = w.lambda[i - 1] + delta;
+      if (w.lambda[i] > LAMBDA_MAX) w.lambda[i] -= range;
+    }
+
+    for (int i = 0; i < SPECTRUM_SAMPLES; i++) w.pdf[i] = 1 / range;
+    return w;
+  }
+
+  /**
+   * Keep only the hero wavelength
+   * Needed when a path's direction starts to depend on wavelength (dispersion),
+   * since the other lanes would no longer follow the same path
+   */
+  void terminateSecondary() {
+    if (secondaryTerminated()) return;
+    for (int i = 1; i < SPECTRUM_SAMPLES; i++) pdf[i] = 0;
+    pdf[0] /= SPECTRUM_SAMPLES;
+  }
+
+  // Whether only the hero wavelength remains
+  bool secondaryTerminated() const {
+    for (int i = 1; i < SPECTRUM_SAMPLES; i++) {
+      if (pdf[i] != 0) return false;
+    }
+    return true;
+  }
+};
+
+/**
+ * Piecewise Gaussian used by the CIE matching function fit below
+ */
+inline double cieLobe(double x, double mu, double sigmaLow, double sigmaHigh) {
+  double t = (x - mu) / (x < mu ? sigmaLow : sigmaHigh);
+  return std::exp(-0.5 * t * t);
+}
+
+/**
+ * CIE 1931 color matching functions
+ * Multi-lobe Gaussian fit from Wyman, Sloan and Shirley, "Simple Analytic
+ * Approximations to the CIE XYZ Color Matching Functions" (JCGT 2013)
+ *
+ * @param lambda Wavelength in nanometres
+ * @return Tristimulus response (x̄, ȳ, z̄) at that wavelength
+ */
+inline vec3 cieXYZ(double lambda) {
+  double x = 1.056 * cieLobe(lambda, 599.8, 37.9, 31.0) +
+             0.362 * cieLobe(lambda, 442.0, 16.0, 26.7) -
+             0.065 * cieLobe(lambda, 501.1, 20.4, 26.2);
+  double y = 0.821 * cieLobe(lambda, 568.8, 46.9, 40.5) +
+             0.286 * cieLobe(lambda, 530.9, 16.3, 31.1);
+  double z = 1.217 * cieLobe(lambda, 437.0, 11.8, 36.0) +
+             0.681 * cieLobe(lambda, 459.0, 26.0, 13.8);
+  return vec3(x, y, z);
+}
+
+// Integral of ȳ over all wavelengths, normalizing XYZ so that Y=1 is white
+const double CIE_Y_INTEGRAL = 106.856895;
+
+// Convert CIE XYZ to linear sRGB (D65 white point)
+inline color xyzToLinearRGB(const vec3& xyz) {
+  return color(3.2404542 * xyz.x() - 1.5371385 * xyz.y() - 0.4985314 * xyz.z(),
+               -0.9692660 * xyz.x() + 1.8760108 * xyz.y() + 0.0415560 * xyz.z(),
+               0.0556434 * xyz.x() - 0.2040259 * xyz.y() + 1.0572252 * xyz.z());
+}
+
+/**
+ * Linear RGB of a spectrum that is 1 at every traced wavelength
+ * Used to white-balance the output so that spectrally flat surfaces stay grey
+ */
+inline color flatSpectrumRGB() {
+  static const color white = []() {
+    vec3 xyz(0, 0, 0);
+    for (double lambda = LAMBDA_MIN; lambda < LAMBDA_MAX; lambda += 1.0) {
+      xyz += cieXYZ(lambda + 0.5);
+    }
+    return xyzToLinearRGB(xyz / CIE_Y_INTEGRAL);
+  }();
+  return white;
+}
+
+/**
+ * Smooth step from 0 at a to 1 at b
+ */
+inline double smoothStep(double a, double b, double x) {
+  double t = std::clamp((x - a) / (b - a), 0.0, 1.0);
+  return t * t * (3 - 2 * t);
+}
+
+/**
+ * Upsample an RGB color to a spectrum at the given wavelengths
+ * Blends three smooth basis spectra (blue, green, red bands) that sum to one
+ * everywhere, so white maps to a flat spectrum and reflectances stay in [0,1]
+ *
+ * @param rgb Linear RGB color
+ * @param w Wavelengths to evaluate the spectrum at
+ * @return The spectrum's value at each wavelength
+ */
+inline sampledSpectrum rgbToSpectrum(const color& rgb, const sampledWavelengths& w) {
+  sampledSpectrum s;
+  for (int i = 0; i < SPECTRUM_SAMPLES; i++) {
+    double blue = 1 - smoothStep(475.0, 505.0, w.lambda[i]);
+    double red = smoothStep(570.0, 600.0, w.lambda[i]);
+    double green = 1 - blue - red;
+    s[i] = blue * rgb.z() + green * rgb.y() + red * rgb.x();
+  }
+  return s;
+}
+
+/**
+ * Convert a path's spectral radiance to a linear RGB sample
+ * Monte Carlo estimate of the XYZ integrals over the path's wavelengths,
+ * then converted to sRGB primaries and white-balanced to the flat spectrum
+ *
+ * @param s Radiance at each of the path's wavelengths
+ * @param w The path's wavelengths and their sampling densities
+ * @return Linear RGB estimate for this sample
+ */
+inline color spectrumToRGB(const sampledSpectrum& s, const sampledWavelengths& w) {
+  vec3 xyz(0, 0, 0);
+  for (int i = 0; i < SPECTRUM_SAMPLES; i++) {
+    if (w.pdf[i] == 0) continue;
+    xyz += (s[i] / w.pdf[i]) * cieXYZ(w.lambda[i]);
+  }
+  xyz /= SPECTRUM_SAMPLES * CIE_Y_INTEGRAL;
+
+  color rgb = xyzToLinearRGB(xyz);
+  color white = flatSpectrumRGB();
+  return color(rgb.x() / white.x(), rgb.y() / white.y(), rgb.z() / white.z());
+}
+
+#endif
@@ -11,14 +11,14 @@ class sphere : public hittable {
  private:
   point3 center;               // Center point of the sphere
   double radius;               // Radius of the sphere
-  shared_ptr<material> mat;    // Material of the sphere
+  int mat;                     // Material ID of the sphere
 
  public:
   /**
    * Construct a sphere with given center, radius, and material
    * Ensures radius is non-negative
    */
-  sphere(const point3& centre, double radius, shared_ptr<material> mat)
+  sphere(const point3& centre, double radius, int mat)
       : center(centre), radius(std::fmax(0, radius)), mat(mat) {}
 
   /**
@@ -27,11 +27,11 @@ class sphere : public hittable {
    * 
    * @param r The ray to test
    * @param rayT Interval of valid ray parameters to consider
-   * @param rec Record to store hit information if intersection occurs
+   * @param rec Record to store the hit distance and primitive in
    * @return true if the ray hits the sphere, false otherwise
    */
-  bool hit(const ray& r, interval rayT,
-           hitRecord& rec) const override {
+  bool intersect(const ray& r, interval rayT,
+                 hitRecord& rec) const override {
     // Vector from ray origin to sphere center
     vec3 oc = center - r.origin();
     
@@ -55,16 +55,47 @@ class sphere : public hittable {
       if (!rayT.surrounds(root)) return false;  // Both intersections invalid
     }
 
-    // Record hit information
+    // Record only what traversal needs; the rest waits for surfaceInteraction()
     rec.t = root;
+    rec.object = this;
+    return true;
+  }
+
+  /**
+   * Compute the hit point, normal and material for the closest hit
+   * 
+   * @param r The ray that hit the sphere
+   * @param rec Record holding the hit distance, completed in place
+   */
+  void surfaceInteraction(const ray& r, hitRecord& rec) const override {
     rec.p = r.at(rec.t);  // Compute intersection point
     
     // Normal points outward from center
     vec3 outwardNormal = (rec.p - center) / radius;
     rec.setFaceNormal(r, outwardNormal);
     
-    rec.mat = mat;  // Set material at intersection
-    return true;
+    rec.mat = mat;  // Set material ID at intersection
+  }
+
+  /**
+   * Determine if the sphere blocks a ray
+   * Same quadratic as hit(), but stops once either root lies in the interval
+   * 
+   * @param r The ray to test
+   * @param rayT Interval of valid ray parameters to consider
+   * @return true if the ray hits the sphere, false otherwise
+   */
+  bool occluded(const ray& r, interval rayT) const override {
+    vec3 oc = center - r.origin();
+    auto a = r.direction().lengthSquared();
+    auto h = dot(r.direction(), oc);
+    auto c = oc.lengthSquared() - radius * radius;
+
+    auto discriminant = h * h - a * c;
+    if (discriminant < 0) return false;
+
+    auto sqrtd = std::sqrt(discriminant);
+    return rayT.surrounds((h - sqrtd) / a) || rayT.surrounds((h + sqrtd) / a);
   }
 };
 
@@ -0,0 +1,178 @@
+#ifndef SPLATBUFFER_H
+#define SPLATBUFFER_H
+
+#include <atomic>
+#include <vector>
+
+#include "framebuffer.h"
+#include "parallel.h"
+
+/**
+ * How concurrent sample contributions to the same pixel are combined
+ */
+enum class splatMode {
+  atomicAdd,  // One shared buffer, updated with relaxed atomic adds (memory independent of thread count)
+  perThread,  // One private full-frame buffer per thread, summed when resolved
+};
+
+/**
+ * Accumulation buffer that many threads can add samples to without locks
+ * Needed when threads split the work by sample rather than by pixel, so any
+ * thread may contribute to any pixel. atomicAdd keeps a single buffer but pays
+ * for contended atomics. perThread never contends but needs one full buffer
+ * per thread and a reduction pass at the end: at 32 bytes per pixel that is
+ * about 118 MB per thread for a 2560x1440 image, or 3.8 GB with 32 threads,
+ * so it only suits small images or few threads.
+ * Every contribution carries a weight, so samples can be spread over several
+ * pixels by a reconstruction filter; resolving divides by the summed weights.
+ * A buffer may cover just a rectangle of the image, given by its origin, so a
+ * thread can splat a tile into a small exclusive buffer (see exclusiveBuffer())
+ * and add it to the shared one with addTile() when the tile is done.
+ */
+class splatBuffer {
+ public:
+  /**
+   * Construct an empty buffer
+   *
+   * @param width Width of the covered rectangle in pixels
+   * @param height Height of the covered rectangle in pixels
+   * @param mode How concurrent contributions are combined
+   * @param x0 Image column of the rectangle's left edge
+   * @param y0 Image row of the rectangle's top edge
+   */
+  splatBuffer(int width, int height, splatMode mode, int x0 = 0, int y0 = 0)
+      : mode(mode), layers(mode == splatMode::perThread ? threadPool::instance().size() : 1) {
+    reset(x0, y0, width, height);
+  }
+
+  /**
+   * Construct an empty buffer that only one thread writes at a time
+   * Its contributions are added with plain stores, so it suits a tile's local
+   * buffer but must never be shared by the threads of a parallelFor loop
+   *
+   * @param width Width of the covered rectangle in pixels
+   * @param height Height of the covered rectangle in pixels
+   * @return Buffer covering a rectangle at the image origin (move it with reset())
+   */
+  static splatBuffer exclusiveBuffer(int width = 0, int height = 0) {
+    splatBuffer buffer(width, height, splatMode::atomicAdd);
+    buffer.exclusive = true;
+    return buffer;
+  }
+
+  /**
+   * Clear the buffer and move it to cover another rectangle of the image
+   * Keeps the allocated storage when the new rectangle is no larger
+   *
+   * @param newX0 Image column of the rectangle's left edge
+   * @param newY0 Image row of the rectangle's top edge
+   * @param newWidth Width of the rectangle in pixels
+   * @param newHeight Height of the rectangle in pixels
+   */
+  void reset(int newX0, int newY0, int newWidth, int newHeight) {
+    x0 = newX0;
+    y0 = newY0;
+    width = newWidth;
+    height = newHeight;
+    sums.assign(CHANNELS * layers * width * height, 0.0);
+  }
+
+  /**
+   * Add a weighted sample's contribution to a pixel
+   * Safe to call concurrently from the threads of a parallelFor loop, except
+   * for exclusive buffers
+   *
+   * @param i Horizontal pixel index in the image, inside the covered rectangle
+   * @param j Vertical pixel index in the image, inside the covered rectangle
+   * @param c Sample color
+   * @param weight Weight of the sample at this pixel
+   */
+  void add(int i, int j, const color& c, double weight = 1.0) {
+    const double contribution[CHANNELS] = {weight * c[0], weight * c[1], weight * c[2], weight};
+    if (mode == splatMode::atomicAdd && !exclusive) {
+      addAtomically(&sums[CHANNELS * ((j - y0) * width + (i - x0))], contribution);
+    } else {
+      int layer = mode == splatMode::perThread ? threadPool::threadIndex() : 0;
+      double* sum = &sums[CHANNELS * ((layer * height + j - y0) * width + (i - x0))];
+      for (int k = 0; k < CHANNELS; k++) sum[k] += contribution[k];
+    }
+  }
+
+  /**
+   * Add the contributions gathered in an exclusive tile buffer
+   * Pixels inside the exclusive rectangle receive samples from this tile only,
+   * so they are added with plain stores; the rest, which neighboring tiles
+   * also splat into, are added atomically. Only valid for shared atomicAdd buffers,
+   * and safe to call concurrently for tiles whose exclusive rectangles do not
+   * overlap any other tile's buffer.
+   *
+   * @param tile Buffer from exclusiveBuffer() covering a rectangle inside this buffer
+   * @param exclusiveX0 Left column of the pixels only this tile contributes to
+   * @param exclusiveY0 Top row of the pixels only this tile contributes to
+   * @param exclusiveX1 Column after the right edge of those pixels
+   * @param exclusiveY1 Row after the bottom edge of those pixels
+   */
+  void addTile(const splatBuffer& tile, int exclusiveX0, int exclusiveY0,
+               int exclusiveX1, int exclusiveY1) {
+    for (int tj = 0; tj < tile.height; tj++) {
+      int j = tile.y0 + tj;
+      for (int ti = 0; ti < tile.width; ti++) {
+        int i = tile.x0 + ti;
+        const double* contribution = &tile.sums[CHANNELS * (tj * tile.width + ti)];
+        if (contribution[0] == 0 && contribution[1] == 0 && contribution[2] == 0 &&
+            contribution[3] == 0) {
+          continue;
+        }
+
+        double* sum = &sums[CHANNELS * ((j - y0) * width + (i - x0))];
+        if (i >= exclusiveX0 && i < exclusiveX1 && j >= exclusiveY0 && j < exclusiveY1) {
+          for (int k = 0; k < CHANNELS; k++) sum[k] += contribution[k];
+        } else {
+          addAtomically(sum, contribution);
+        }
+      }
+    }
+  }
+
+  /**
+   * Write the weighted average of each covered pixel's contributions to an image
+   * Reduces rows in parallel; pixels with no positive total weight are black.
+   * Must not run concurrently with add()
+   *
+   * @param fb Image to write, containing the covered rectangle
+   */
+  void resolve(framebuffer& fb) const {
+    parallelFor(0, height, [&](int j) {
+      for (int i = 0; i < width; i++) {
+        color total(0, 0, 0);
+        double totalWeight = 0;
+        for (int layer = 0; layer < layers; layer++) {
+          const double* sum = &sums[CHANNELS * ((layer * height + j) * width + i)];
+          total += color(sum[0], sum[1], sum[2]);
+          totalWeight += sum[3];
+        }
+        fb.pixels[fb.index(x0 + i, y0 + j)] = totalWeight > 0 ? total / totalWeight : color(0, 0, 0);
+      }
+    });
+  }
+
+ private:
+  int x0, y0;                // Image position of the covered rectangle's top-left pixel
+  int width;                 // Width of the covered rectangle in pixels
+  int height;                // Height of the covered rectangle in pixels
+  splatMode mode;            // How concurrent contributions are combined
+  bool exclusive = false;    // Written by one thread at a time, so plain stores suffice
+  int layers;                // Number of buffers (one per thread for perThread)
+  std::vector<double> sums;  // Weighted RGB and weight sums, layer-major then row-major
+
+  static constexpr int CHANNELS = 4;  // Values per pixel: weighted R, G, B and the weight
+
+  // Add one pixel's channel values to a shared sum with relaxed atomic adds
+  static void addAtomically(double* sum, const double* contribution) {
+    for (int k = 0; k < CHANNELS; k++) {
+      std::atomic_ref<double>(sum[k]).fetch_add(contribution[k], std::memory_order_relaxed);
+    }
+  }
+};
+
+#endif
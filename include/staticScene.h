@@ -0,0 +1,155 @@
+#ifndef STATICSCENE_H
+#define STATICSCENE_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <tuple>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "hittable.h"
+#include "hittableList.h"
+#include "utils.h"
+
+/**
+ * Scene whose set of primitive types is fixed at compile time
+ * Primitives are stored by value, in one contiguous array per type, and are
+ * called through their concrete types, so traversal makes no virtual calls and
+ * the compiler can inline every intersection test. The camera's rendering
+ * methods are templates over the scene type, so rendering a staticScene
+ * instantiates an integrator specialized for exactly these primitives.
+ * Scenes whose contents are only known at run time should use hittableList.
+ *
+ * @tparam Primitives Distinct concrete hittable types the scene may contain
+ */
+template <typename... Primitives>
+class staticScene {
+ public:
+  /**
+   * Construct an empty scene
+   *
+   * @param resource Memory resource the primitive arrays are allocated from
+   */
+  explicit staticScene(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : primitives(std::pmr::vector<Primitives>(resource)...) {}
+
+  // Add a primitive to the array for its type
+  template <typename P>
+  void add(const P& primitive) {
+    std::get<std::pmr::vector<P>>(primitives).push_back(primitive);
+  }
+
+  /**
+   * Copy the primitives of a dynamic scene into this one
+   * Objects whose exact type is not among Primitives are skipped
+   *
+   * @param list The dynamic scene to copy
+   * @return true if every object in the list was copied
+   */
+  bool addAll(const hittableList& list) {
+    bool complete = true;
+    for (const auto& obj : list.objects) {
+      complete &= (addIfType<Primitives>(*obj) || ...);
+    }
+    return complete;
+  }
+
+  // Total number of primitives in the scene
+  std::size_t size() const {
+    return std::apply([](const auto&... lists) { return (lists.size() + ...); }, primitives);
+  }
+
+  /**
+   * Determine if a ray intersects the scene (closest-hit query)
+   * Same contract as hittable::hit(): only the closest primitive has its
+   * surface interaction computed, dispatched on the type that produced it
+   *
+   * @param r The ray to test
+   * @param rayT Interval of valid ray parameters to consider
+   * @param rec Record to store hit information if intersection occurs
+   * @return true if the ray hits the scene, false otherwise
+   */
+  bool hit(const ray& r, interval rayT, hitRecord& rec) const {
+    std::size_t hitType = sizeof...(Primitives);  // Type index of the closest hit, if any
+    intersectAll(r, rayT, rec, hitType, std::index_sequence_for<Primitives...>{});
+    if (hitType == sizeof...(Primitives)) return false;
+
+    completeHit(r, rec, hitType, std::index_sequence_for<Primitives...>{});
+    return true;
+  }
+
+  /**
+   * Determine if anything in the scene blocks a ray (any-hit query)
+   *
+   * @param r The ray to test
+   * @param rayT Interval of valid ray parameters to consider
+   * @return true if any primitive is hit, false otherwise
+   */
+  bool occluded(const ray& r, interval rayT) const {
+    return std::apply(
+        [&](const auto&... lists) { return (anyOccludes(lists, r, rayT) || ...); },
+        primitives);
+  }
+
+ private:
+  std::tuple<std::pmr::vector<Primitives>...> primitives;  // One array per primitive type
+
+  // The primitive type with index I in the type list
+  template <std::size_t I>
+  using primitiveType = std::tuple_element_t<I, std::tuple<Primitives...>>;
+
+  // Copy obj into the scene if its exact dynamic type is P
+  template <typename P>
+  bool addIfType(const hittable& obj) {
+    if (typeid(obj) != typeid(P)) return false;
+    add(static_cast<const P&>(obj));
+    return true;
+  }
+
+  /**
+   * Find the closest hit among the primitives of every type
+   * Qualified calls (P::intersect) bind statically, so they can be inlined
+   *
+   * @param r The ray to test
+   * @param rayT Interval of valid ray parameters, shrunk as hits are found
+   * @param rec Record to store the closest hit distance and primitive in
+   * @param hitType Receives the type index of the closest hit
+   */
+  template <std::size_t... I>
+  void intersectAll(const ray& r, interval& rayT, hitRecord& rec, std::size_t& hitType,
+                    std::index_sequence<I...>) const {
+    auto intersectType = [&](auto index) {
+      using P = primitiveType<decltype(index)::value>;
+      for (const P& prim : std::get<decltype(index)::value>(primitives)) {
+        if (prim.P::intersect(r, rayT, rec)) {
+          rayT.max = rec.t;
+          hitType = decltype(index)::value;
+        }
+      }
+    };
+    (intersectType(std::integral_constant<std::size_t, I>{}), ...);
+  }
+
+  // Compute the surface interaction of the closest hit through its concrete type
+  template <std::size_t... I>
+  static void completeHit(const ray& r, hitRecord& rec, std::size_t hitType,
+                          std::index_sequence<I...>) {
+    auto completeAs = [&](auto index) {
+      using P = primitiveType<decltype(index)::value>;
+      static_cast<const P*>(rec.object)->P::surfaceInteraction(r, rec);
+    };
+    ((hitType == I ? completeAs(std::integral_constant<std::size_t, I>{}) : void()), ...);
+  }
+
+  // Whether any primitive of one type blocks a ray
+  template <typename P>
+  static bool anyOccludes(const std::pmr::vector<P>& list, const ray& r, interval rayT) {
+    for (const P& prim : list) {
+      if (prim.P::occluded(r, rayT)) return true;
+    }
+    return false;
+  }
+};
+
+#endif
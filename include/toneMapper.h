@@ -0,0 +1,143 @@
+#ifndef TONEMAPPER_H
+#define TONEMAPPER_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "framebuffer.h"
+#include "parallel.h"
+
+/**
+ * Curve that compresses linear HDR values into the displayable range
+ */
+enum class toneCurve {
+  clip,      // Clamp to [0,1]; highlights saturate
+  reinhard,  // x / (1 + x); rolls highlights off gently
+  aces,      // Narkowicz's fit of the ACES filmic curve; adds contrast
+};
+
+/**
+ * Encoding applied to display-linear values before quantizing to 8 bits
+ */
+enum class transferFunction {
+  gamma2,  // Square root, the renderer's original approximation
+  sRGB,    // Piecewise sRGB OETF (linear toe, then a 1/2.4 power)
+};
+
+/**
+ * Post-render color pipeline from a linear HDR image to 8-bit display RGB
+ * Applies exposure, a tone curve, a transfer function and optional dithering
+ * to the whole image after rendering, so an image (e.g. one saved with
+ * writeImageHDR()) can be re-exposed or re-graded without tracing any rays.
+ * Rows are mapped in parallel, each as one flat array of channel values, with
+ * branch-free loop bodies that the compiler vectorizes.
+ * The defaults reproduce the original gamma 2 and hard clip output exactly.
+ */
+class toneMapper {
+ public:
+  double exposure = 0;                                   // Exposure adjustment in stops (+1 doubles brightness)
+  toneCurve curve = toneCurve::clip;                     // Highlight compression curve
+  transferFunction transfer = transferFunction::gamma2;  // Display encoding
+  bool dither = false;                                   // Randomize rounding to break up banding
+
+  /**
+   * Convert an image to 8-bit display values
+   *
+   * @param fb Linear HDR image
+   * @param bytes Receives 3 bytes (R, G, B) per pixel in row-major order
+   * @param scale Factor applied to every pixel first, e.g. 1/passes for accumulation buffers
+   */
+  void apply(const framebuffer& fb, std::vector<unsigned char>& bytes,
+             double scale = 1.0) const {
+    static_assert(sizeof(color) == 3 * sizeof(double), "rows are mapped as flat arrays");
+
+    bytes.resize(3 * fb.size());
+    double gain = scale * std::exp2(exposure);
+    parallelFor(0, fb.height, [&](int j) {
+      const double* in = fb.pixels[fb.index(0, j)].e;
+      unsigned char* out = &bytes[3 * fb.index(0, j)];
+      switch (curve) {
+        case toneCurve::clip: mapRow<toneCurve::clip>(in, out, 3 * fb.width, j, gain); break;
+        case toneCurve::reinhard: mapRow<toneCurve::reinhard>(in, out, 3 * fb.width, j, gain); break;
+        case toneCurve::aces: mapRow<toneCurve::aces>(in, out, 3 * fb.width, j, gain); break;
+      }
+    });
+  }
+
+ private:
+  /**
+   * Apply the tone curve to a value
+   *
+   * @param v Exposed linear value (non-negative)
+   * @return Display-linear value (in [0,1] except for clip, which is clamped later)
+   */
+  template <toneCurve Curve>
+  static double applyCurve(double v) {
+    if constexpr (Curve == toneCurve::reinhard) {
+      return v / (1 + v);
+    } else if constexpr (Curve == toneCurve::aces) {
+      return v * (2.51 * v + 0.03) / (v * (2.43 * v + 0.59) + 0.14);
+    } else {
+      return v;
+    }
+  }
+
+  /**
+   * Apply the transfer function to a display-linear value
+   *
+   * @param v Display-linear value (non-negative)
+   * @return Encoded value
+   */
+  template <transferFunction Transfer>
+  static double encode(double v) {
+    if constexpr (Transfer == transferFunction::sRGB) {
+      v = std::min(v, 1.0);
+      return v <= 0.0031308 ? 12.92 * v : 1.055 * std::pow(v, 1 / 2.4) - 0.055;
+    } else {
+      return std::sqrt(v);
+    }
+  }
+
+  // Dispatch a row on the transfer function, so every loop body is branch-free
+  template <toneCurve Curve>
+  void mapRow(const double* in, unsigned char* out, int count, int row, double gain) const {
+    if (transfer == transferFunction::sRGB) {
+      mapRowKernel<Curve, transferFunction::sRGB>(in, out, count, row, gain);
+    } else {
+      mapRowKernel<Curve, transferFunction::gamma2>(in, out, count, row, gain);
+    }
+  }
+
+  /**
+   * Map one row of channel values to bytes
+   * Without dithering values are truncated as the original output did; with
+   * it, interleaved gradient noise (Jimenez 2014) in [0,1) is added before
+   * truncating, which rounds each value up with probability equal to its
+   * fractional part
+   *
+   * @param in Linear channel values of the row (R, G, B per pixel)
+   * @param out Receives the row's bytes
+   * @param count Number of channel values in the row
+   * @param row Row index, used to decorrelate the dither pattern
+   * @param gain Exposure and scale factor applied to every value
+   */
+  template <toneCurve Curve, transferFunction Transfer>
+  void mapRowKernel(const double* in, unsigned char* out, int count, int row, double gain) const {
+    const double noiseAmount = dither ? 1.0 : 0.0;
+    const double quantize = dither ? 255.0 : 255.999;
+    const double maxLevel = dither ? 255.999 : 255.999 * 0.999;
+
+    for (int k = 0; k < count; k++) {
+      double v = encode<Transfer>(applyCurve<Curve>(std::max(gain * in[k], 0.0)));
+
+      double n = 0.06711056 * k + 0.00583715 * row;
+      n = 52.9829189 * (n - std::floor(n));
+      n = noiseAmount * (n - std::floor(n));
+
+      out[k] = static_cast<unsigned char>(std::clamp(quantize * v + n, 0.0, maxLevel));
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef TRAVERSAL_H
+#define TRAVERSAL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * Order in which the renderer visits the pixels of an image
+ * Space-filling curves keep consecutive rays close together on screen, so
+ * they tend to touch the same scene data while it is still in cache
+ */
+enum class traversalOrder {
+  scanline,  // Rows top to bottom, one parallel task per row
+  morton,    // Tiles along a Z-order curve, pixels in Z-order within each tile
+  hilbert,   // Tiles along a Hilbert curve, pixels in Z-order within each tile
+};
+
+/**
+ * Extract the even bits of a 32-bit value and pack them into the low 16 bits
+ * Inverse of interleaving a coordinate into a Morton code
+ */
+inline uint32_t compactBits(uint32_t v) {
+  v &= 0x55555555;
+  v = (v | (v >> 1)) & 0x33333333;
+  v = (v | (v >> 2)) & 0x0f0f0f0f;
+  v = (v | (v >> 4)) & 0x00ff00ff;
+  v = (v | (v >> 8)) & 0x0000ffff;
+  return v;
+}
+
+/**
+ * Convert a position along the Z-order (Morton) curve to 2D coordinates
+ *
+ * @param code Position along the curve
+ * @param x Receives the horizontal coordinate
+ * @param y Receives the vertical coordinate
+ */
+inline void mortonDecode(uint32_t code, int& x, int& y) {
+  x = static_cast<int>(compactBits(code));
+  y = static_cast<int>(compactBits(code >> 1));
+}
+
+/**
+ * Convert a position along the Hilbert curve to 2D coordinates
+ * Unlike the Z-order curve, consecutive positions are always adjacent cells
+ *
+ * @param n Side of the square grid covered by the curve (power of two)
+ * @param d Position along the curve, in [0, n*n)
+ * @param x Receives the horizontal coordinate
+ * @param y Receives the vertical coordinate
+ */
+inline void hilbertDecode(int n, int d, int& x, int& y) {
+  x = y = 0;
+  for (int s = 1; s < n; s *= 2) {
+    int rx = 1 & (d / 2);
+    int ry = 1 & (d ^ rx);
+
+    // Rotate the quadrant so the sub-curves join up
+    if (ry == 0) {
+      if (rx == 1) {
+        x = s - 1 - x;
+        y = s - 1 - y;
+      }
+      std::swap(x, y);
+    }
+
+    x += s * rx;
+    y += s * ry;
+    d /= 4;
+  }
+}
+
+// Smallest power of two that is at least n
+inline int nextPowerOfTwo(int n) {
+  int p = 1;
+  while (p < n) p *= 2;
+  return p;
+}
+
+/**
+ * List the tiles of a grid in curve order
+ * The curve covers the smallest power-of-two square around the grid and
+ * cells outside the grid are skipped
+ *
+ * @param order Curve to follow (morton or hilbert)
+ * @param tilesX Number of tile columns
+ * @param tilesY Number of tile rows
+ * @param tiles Receives tile indices (ty * tilesX + tx) in visiting order
+ */
+inline void buildTileOrder(traversalOrder order, int tilesX, int tilesY,
+                           std::vector<int>& tiles) {
+  tiles.clear();
+  int n = nextPowerOfTwo(std::max(tilesX, tilesY));
+  for (int d = 0; d < n * n; d++) {
+    int tx, ty;
+    if (order == traversalOrder::hilbert) {
+      hilbertDecode(n, d, tx, ty);
+    } else {
+      mortonDecode(static_cast<uint32_t>(d), tx, ty);
+    }
+    if (tx < tilesX && ty < tilesY) tiles.push_back(ty * tilesX + tx);
+  }
+}
+
+#endif
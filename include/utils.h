@@ -2,6 +2,7 @@
 #define UTILS_H
 
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <limits>
 #include <memory>
@@ -24,17 +25,39 @@ const double PI = std::numbers::pi;                          // Pi constant
  */
 inline double degreesToRadians(double d) { return d * PI / 180.0; }
 
+// The calling thread's random number generator, randomly seeded on first use
+inline std::mt19937& randomGenerator() {
+  static thread_local std::mt19937 generator(std::random_device{}());
+  return generator;
+}
+
+/**
+ * Reseed the calling thread's random number generator
+ * Combining a base seed with a stream number (e.g. a row index) gives each
+ * piece of work its own reproducible sequence, whichever thread runs it
+ *
+ * @param seed Base seed
+ * @param stream Index of the independent sequence to start
+ */
+inline void seedRandom(std::uint64_t seed, std::uint64_t stream = 0) {
+  // SplitMix64 finalizer, so nearby seeds and streams give unrelated sequences
+  std::uint64_t z = seed + 0x9e3779b97f4a7c15ull * (stream + 1);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  randomGenerator().seed(static_cast<std::mt19937::result_type>(z ^ (z >> 31)));
+}
+
 /**
  * Generate a random double in the range [0,1)
  * Uses the Mersenne Twister engine for high-quality random numbers
+ * Each thread has its own generator so rendering threads never share state
  * 
  * @return Random double between 0 and 1
  */
 inline double randomDouble() {
   // Static to ensure initialization happens only once for better performance
-  static std::uniform_real_distribution<double> distribution(0.0, 1.0);
-  static std::mt19937 generator(std::random_device{}());
-  return distribution(generator);
+  static thread_local std::uniform_real_distribution<double> distribution(0.0, 1.0);
+  return distribution(randomGenerator());
 }
 
 /**
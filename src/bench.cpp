@@ -0,0 +1,504 @@
+#include "../include/arena.h"
+#include "../include/camera.h"
+#include "../include/hittable.h"
+#include "../include/hittableList.h"
+#include "../include/imageMetrics.h"
+#include "../include/previewServer.h"
+#include "../include/utils.h"
+#include "../include/scenes.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+/**
+ * Micro-benchmarks for the ray tracer's building blocks
+ *
+ * Usage: raytracingBench [name]
+ * Runs the named benchmark, or all of them when no name is given
+ */
+
+// Every heap allocation made by this process, for the allocation benchmark
+static std::atomic<long> heapAllocations{0};
+
+void* operator new(std::size_t size) {
+  heapAllocations++;
+  if (void* p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+  heapAllocations++;
+  auto alignment = static_cast<std::size_t>(align);
+  if (void* p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+/**
+ * Measure the wall-clock time of a callable
+ *
+ * @param fn Work to time
+ * @return Elapsed time in seconds
+ */
+template <typename F>
+double timeSeconds(F&& fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Compare closest-hit and any-hit queries on visibility rays
+ * Each ray joins two random points among the spheres, as a shadow ray
+ * from a surface to a light would
+ *
+ * @param world The scene to trace rays against
+ */
+void benchOcclusion(const hittable& world) {
+  const int rayCount = 1000000;
+
+  std::vector<ray> rays;
+  rays.reserve(rayCount);
+  for (int k = 0; k < rayCount; k++) {
+    point3 from(randomDouble(-11, 11), randomDouble(0, 2), randomDouble(-11, 11));
+    point3 to(randomDouble(-11, 11), randomDouble(0, 2), randomDouble(-11, 11));
+    rays.emplace_back(from, to - from);
+  }
+
+  // Only the segment between the two points matters for visibility
+  const interval segment(0.001, 0.999);
+
+  int blockedByHit = 0;
+  double hitTime = timeSeconds([&]() {
+    hitRecord rec;
+    for (const auto& r : rays) blockedByHit += world.hit(r, segment, rec);
+  });
+
+  int blockedByOccluded = 0;
+  double occludedTime = timeSeconds([&]() {
+    for (const auto& r : rays) blockedByOccluded += world.occluded(r, segment);
+  });
+
+  std::cout << "occlusion: " << rayCount << " visibility rays, "
+            << blockedByHit << " blocked\n"
+            << "  hit:      " << rayCount / hitTime / 1e6 << " Mrays/s\n"
+            << "  occluded: " << rayCount / occludedTime / 1e6 << " Mrays/s ("
+            << hitTime / occludedTime << "x)\n";
+
+  if (blockedByHit != blockedByOccluded) {
+    std::cout << "  MISMATCH: occluded reported " << blockedByOccluded << " blocked\n";
+  }
+}
+
+/**
+ * Count the surface interactions saved by deferring them to the closest hit
+ * Before lazy evaluation, every candidate hit accepted during traversal
+ * computed its point, normal and material; now only the closest one does
+ *
+ * @param world The scene to trace rays against
+ */
+void benchLazyHits(const hittableList& world) {
+  const int rayCount = 1000000;
+
+  // Primary rays from the example camera position towards the sphere field
+  const point3 eye(13, 2, 3);
+  std::vector<ray> rays;
+  rays.reserve(rayCount);
+  for (int k = 0; k < rayCount; k++) {
+    point3 target(randomDouble(-11, 11), randomDouble(0, 1), randomDouble(-11, 11));
+    rays.emplace_back(eye, target - eye);
+  }
+
+  // Replay the list traversal, counting every hit that shrank the interval
+  long candidates = 0, closest = 0;
+  for (const auto& r : rays) {
+    hitRecord rec;
+    auto closestSoFar = INF;
+    bool hitAnything = false;
+    for (const auto& obj : world.objects) {
+      if (obj->intersect(r, interval(0.001, closestSoFar), rec)) {
+        candidates++;
+        hitAnything = true;
+        closestSoFar = rec.t;
+      }
+    }
+    closest += hitAnything;
+  }
+
+  int hits = 0;
+  double hitTime = timeSeconds([&]() {
+    hitRecord rec;
+    for (const auto& r : rays) hits += world.hit(r, interval(0.001, INF), rec);
+  });
+
+  std::cout << "lazyhits: " << rayCount << " primary rays, " << hits << " hit\n"
+            << "  surface interactions per ray, eager: "
+            << static_cast<double>(candidates) / rayCount
+            << ", lazy: " << static_cast<double>(closest) / rayCount << "\n"
+            << "  saved per ray: " << static_cast<double>(candidates - closest) / rayCount
+            << "\n"
+            << "  hit: " << rayCount / hitTime / 1e6 << " Mrays/s\n";
+}
+
+/**
+ * Count heap allocations during scene construction and steady-state rendering
+ * Scene construction should need only a handful of arena blocks, and once the
+ * worker threads and buffers exist, rendering passes and sending preview
+ * frames should allocate nothing
+ *
+ * @return true if steady-state rendering made no heap allocations
+ */
+bool benchAllocations() {
+  long before = heapAllocations;
+  arena sceneArena;
+  hittableList world(sceneArena.get());
+  materialList materials(sceneArena.get());
+  randomSpheresScene(world, materials, sceneArena);
+  long sceneAllocations = heapAllocations - before;
+
+  camera cam = exampleCamera(160, 10);
+
+  // Frames are encoded as the preview server sends them, into a stream that
+  // discards them; its frame log is silenced the same way
+  previewServer server(cam, world, materials);
+  std::ostream discard(nullptr);
+  std::streambuf* log = std::clog.rdbuf(nullptr);
+  auto changeTime = std::chrono::steady_clock::now();
+  auto sendFrame = [&](const framebuffer& fb, int block) {
+    server.emit(discard, fb, 1, cam.toneMapping, changeTime, block);
+  };
+
+  // Warm up: starts the worker threads and sizes the accumulation buffer
+  framebuffer accum;
+  cam.renderCoarseToFine(world, materials, accum, sendFrame);
+  cam.accumulatePass(world, materials, accum);
+
+  before = heapAllocations;
+  const int passes = 4;
+  for (int k = 0; k < passes; k++) {
+    cam.accumulatePass(world, materials, accum);
+    server.emit(discard, accum, k + 2, cam.toneMapping, changeTime);
+  }
+  long passAllocations = heapAllocations - before;
+
+  before = heapAllocations;
+  cam.renderCoarseToFine(world, materials, accum, sendFrame);
+  long previewAllocations = heapAllocations - before;
+  std::clog.rdbuf(log);
+
+  bool ok = passAllocations == 0 && previewAllocations == 0;
+  std::cout << "allocs: scene of " << world.objects.size() << " spheres and "
+            << materials.materials.size() << " materials: " << sceneAllocations
+            << " heap allocations\n"
+            << "  " << passes << " accumulation passes and frames: " << passAllocations
+            << " heap allocations\n"
+            << "  coarse-to-fine preview frames: " << previewAllocations
+            << " heap allocations\n"
+            << (ok ? "  OK\n" : "  FAIL: steady-state rendering allocated\n");
+  return ok;
+}
+
+/**
+ * Compare row ownership with sample-partitioned rendering into a shared
+ * splat buffer, using both atomic adds and per-thread buffers
+ *
+ * @param world The scene to trace rays against
+ * @param materials The materials referenced by the scene
+ */
+void benchSplatting(const hittable& world, const materialList& materials) {
+  camera cam = exampleCamera(160, 16);
+
+  auto timeRender = [&]() {
+    return timeSeconds([&]() { cam.renderImage(world, materials); });
+  };
+
+  cam.partitionSamples = false;
+  double rowTime = timeRender();
+
+  cam.partitionSamples = true;
+  cam.sampleAccumulation = splatMode::atomicAdd;
+  double atomicTime = timeRender();
+
+  cam.sampleAccumulation = splatMode::perThread;
+  double perThreadTime = timeRender();
+
+  std::cout << "splatting: " << threadPool::instance().size() << " threads, "
+            << cam.imageWidth << " px wide at " << cam.samplesPerPixel << " spp\n"
+            << "  row ownership:         " << rowTime << " s\n"
+            << "  samples, atomic adds:  " << atomicTime << " s\n"
+            << "  samples, per-thread:   " << perThreadTime << " s\n";
+}
+
+/**
+ * Compare render time for each pixel traversal order
+ * For cache behaviour, run the main executable with each --traversal option
+ * under e.g. `perf stat -e L1-dcache-load-misses,LLC-load-misses`
+ *
+ * @param world The scene to trace rays against
+ * @param materials The materials referenced by the scene
+ */
+void benchTraversal(const hittable& world, const materialList& materials) {
+  camera cam = exampleCamera(320, 4);
+
+  std::cout << "traversal: " << cam.imageWidth << " px wide at "
+            << cam.samplesPerPixel << " spp\n";
+
+  const std::pair<traversalOrder, const char*> orders[] = {
+      {traversalOrder::scanline, "scanline"},
+      {traversalOrder::morton, "morton"},
+      {traversalOrder::hilbert, "hilbert"},
+  };
+  for (const auto& [order, name] : orders) {
+    cam.traversal = order;
+    double seconds = timeSeconds([&]() { cam.renderImage(world, materials); });
+    std::cout << "  " << name << ": " << seconds << " s\n";
+  }
+}
+
+/**
+ * Compare the cost of RGB and hero-wavelength spectral rendering
+ * Both trace the same number of paths; the spectral renderer carries four
+ * wavelengths per path and converts each sample through the CIE curves
+ *
+ * @param world The scene to trace rays against
+ * @param materials The materials referenced by the scene
+ */
+void benchSpectral(const hittable& world, const materialList& materials) {
+  camera cam = exampleCamera(160, 16);
+
+  cam.spectral = false;
+  double rgbTime = timeSeconds([&]() { cam.renderImage(world, materials); });
+
+  cam.spectral = true;
+  double spectralTime = timeSeconds([&]() { cam.renderImage(world, materials); });
+
+  std::cout << "spectral: " << cam.imageWidth << " px wide at "
+            << cam.samplesPerPixel << " spp\n"
+            << "  rgb:      " << rgbTime << " s\n"
+            << "  spectral: " << spectralTime << " s (" << spectralTime / rgbTime
+            << "x)\n";
+}
+
+/**
+ * Compare the virtual-dispatch scene with the compile-time specialized one
+ * Both hold the same spheres; the specialized scene stores them by value and
+ * the camera is instantiated for it, so no bounce makes a virtual call
+ *
+ * @param world The dynamic scene, copied into the specialized one
+ * @param materials The materials referenced by the scene
+ */
+void benchStaticScene(const hittableList& world, const materialList& materials) {
+  sphereScene specialized;
+  specialized.addAll(world);
+
+  const int rayCount = 1000000;
+  const point3 eye(13, 2, 3);
+  std::vector<ray> rays;
+  rays.reserve(rayCount);
+  for (int k = 0; k < rayCount; k++) {
+    point3 target(randomDouble(-11, 11), randomDouble(0, 1), randomDouble(-11, 11));
+    rays.emplace_back(eye, target - eye);
+  }
+
+  // Both scenes must report the same closest hits (up to rounding, since
+  // inlining lets fast-math contract the arithmetic differently)
+  int mismatches = 0;
+  for (const auto& r : rays) {
+    hitRecord a, b;
+    bool hitA = world.hit(r, interval(0.001, INF), a);
+    bool hitB = specialized.hit(r, interval(0.001, INF), b);
+    if (hitA != hitB || (hitA && (std::abs(a.t - b.t) > 1e-9 * a.t || a.mat != b.mat))) mismatches++;
+  }
+
+  int hits = 0;
+  auto timeHits = [&](const auto& scene) {
+    double seconds = timeSeconds([&]() {
+      hitRecord rec;
+      for (const auto& r : rays) hits += scene.hit(r, interval(0.001, INF), rec);
+    });
+    return rayCount / seconds / 1e6;
+  };
+  double dynamicRate = timeHits(world);
+  double staticRate = timeHits(specialized);
+
+  camera cam = exampleCamera(160, 16);
+
+  double dynamicTime = timeSeconds([&]() { cam.renderImage(world, materials); });
+  double staticTime = timeSeconds([&]() { cam.renderImage(specialized, materials); });
+
+  std::cout << "staticscene: " << specialized.size() << " spheres, " << rayCount
+            << " primary rays, " << hits / 2 << " hit\n"
+            << "  hit, dynamic: " << dynamicRate << " Mrays/s\n"
+            << "  hit, static:  " << staticRate << " Mrays/s ("
+            << staticRate / dynamicRate << "x)\n"
+            << "  render, dynamic: " << dynamicTime << " s\n"
+            << "  render, static:  " << staticTime << " s ("
+            << dynamicTime / staticTime << "x)\n";
+
+  if (mismatches) std::cout << "  MISMATCH: " << mismatches << " rays hit differently\n";
+}
+
+/**
+ * Compare the bulk color pipeline with per-pixel gamma and clamping
+ * The per-pixel loop is how images were converted before the pipeline existed
+ */
+void benchToneMapping() {
+  framebuffer fb(2560, 1440);
+  for (auto& pixel : fb.pixels) pixel = 2.0 * vec3::random();
+
+  std::vector<unsigned char> bytes(3 * fb.size());
+  double perPixelTime = timeSeconds([&]() {
+    static const interval intensity(0.000, 0.999);
+    for (int p = 0; p < fb.size(); p++) {
+      for (int c = 0; c < 3; c++) {
+        double v = linearToGamma(fb.pixels[p][c]);
+        bytes[3 * p + c] = static_cast<unsigned char>(255.999 * intensity.clamp(v));
+      }
+    }
+  });
+
+  std::cout << "tonemap: " << fb.width << "x" << fb.height << "\n"
+            << "  per-pixel gamma 2: " << perPixelTime * 1e3 << " ms\n";
+
+  toneMapper tones;
+  tones.apply(fb, bytes);  // Warm up: starts the worker threads
+  double defaultTime = timeSeconds([&]() { tones.apply(fb, bytes); });
+  std::cout << "  pipeline, clip + gamma 2: " << defaultTime * 1e3 << " ms\n";
+
+  tones.exposure = -0.5;
+  tones.curve = toneCurve::aces;
+  tones.transfer = transferFunction::sRGB;
+  tones.dither = true;
+  double filmicTime = timeSeconds([&]() { tones.apply(fb, bytes); });
+  std::cout << "  pipeline, aces + sRGB + dither: " << filmicTime * 1e3 << " ms\n";
+}
+
+/**
+ * Compare render time and noise of the pixel reconstruction filters
+ * Noise is estimated from two independent renders of the same view: their
+ * RMS difference is sqrt(2) times the noise of each (values clamped to [0,1])
+ *
+ * @param world The scene to trace rays against
+ * @param materials The materials referenced by the scene
+ */
+void benchFilters(const hittable& world, const materialList& materials) {
+  camera cam = exampleCamera(160, 4);
+
+  std::cout << "filters: " << cam.imageWidth << " px wide at " << cam.samplesPerPixel
+            << " spp\n";
+
+  const std::pair<filterType, const char*> filters[] = {
+      {filterType::box, "box"},
+      {filterType::gaussian, "gaussian"},
+      {filterType::mitchell, "mitchell"},
+      {filterType::blackmanHarris, "blackman-harris"},
+  };
+  for (const auto& [filter, name] : filters) {
+    cam.filter = filter;
+    framebuffer first, second;
+    double seconds = timeSeconds([&]() { first = cam.renderImage(world, materials); });
+    second = cam.renderImage(world, materials);
+
+    double sumSquares = 0;
+    for (int p = 0; p < first.size(); p++) {
+      for (int c = 0; c < 3; c++) {
+        double d = std::clamp(first.pixels[p][c], 0.0, 1.0) -
+                   std::clamp(second.pixels[p][c], 0.0, 1.0);
+        sumSquares += d * d;
+      }
+    }
+    double noise = std::sqrt(sumSquares / (3 * first.size()) / 2);
+    std::cout << "  " << name << ": " << seconds << " s, noise " << noise << "\n";
+  }
+}
+
+/**
+ * Compare denoised low-sample renders with plain renders at higher sample counts
+ * Error is the RMS difference from a 256 spp reference (values clamped to
+ * [0,1]), so it includes the denoiser's bias as well as the remaining noise,
+ * and also the reference's own small noise
+ *
+ * @param world The scene to trace rays against
+ * @param materials The materials referenced by the scene
+ */
+void benchDenoising(const hittable& world, const materialList& materials) {
+  camera cam = exampleCamera(320, 256);
+  framebuffer reference = cam.renderImage(world, materials);
+
+  auto errorOf = [&](const framebuffer& fb) {
+    double sumSquares = 0;
+    for (int p = 0; p < fb.size(); p++) {
+      for (int c = 0; c < 3; c++) {
+        double d = std::clamp(fb.pixels[p][c], 0.0, 1.0) -
+                   std::clamp(reference.pixels[p][c], 0.0, 1.0);
+        sumSquares += d * d;
+      }
+    }
+    return std::sqrt(sumSquares / (3 * fb.size()));
+  };
+
+  // FLIP compares images as displayed, so both go through the 8-bit color pipeline
+  auto displayed = [&](const framebuffer& fb) {
+    std::vector<unsigned char> bytes;
+    cam.toneMapping.apply(fb, bytes);
+    framebuffer out(fb.width, fb.height);
+    for (int p = 0; p < out.size(); p++) {
+      out.pixels[p] = color(bytes[3 * p], bytes[3 * p + 1], bytes[3 * p + 2]) / 255;
+    }
+    return out;
+  };
+  framebuffer displayedReference = displayed(reference);
+  auto flipOf = [&](const framebuffer& fb) { return imageFLIP(displayedReference, displayed(fb)); };
+
+  std::cout << "denoising: " << cam.imageWidth << " px wide, error and FLIP against "
+            << cam.samplesPerPixel << " spp\n";
+
+  for (int spp : {16, 32, 64}) {
+    cam.samplesPerPixel = spp;
+    framebuffer fb;
+    double seconds = timeSeconds([&]() { fb = cam.renderImage(world, materials); });
+    std::cout << "  " << spp << " spp: " << seconds << " s, error " << errorOf(fb)
+              << ", FLIP " << flipOf(fb) << "\n";
+  }
+
+  cam.samplesPerPixel = 16;
+  cam.denoise = true;
+  framebuffer fb;
+  double renderSeconds = timeSeconds([&]() { fb = cam.renderImage(world, materials); });
+  double denoiseSeconds = timeSeconds([&]() { cam.denoiserSettings.apply(fb); });
+  std::cout << "  16 spp denoised: " << renderSeconds << " s + " << denoiseSeconds
+            << " s denoising, error " << errorOf(fb) << ", FLIP " << flipOf(fb) << "\n";
+}
+
+int main(int argc, char* argv[]) {
+  arena sceneArena;
+  hittableList world(sceneArena.get());
+  materialList materials(sceneArena.get());
+  randomSpheresScene(world, materials, sceneArena);
+
+  const char* name = argc > 1 ? argv[1] : nullptr;
+  auto selected = [&](const char* bench) { return !name || !std::strcmp(name, bench); };
+
+  if (selected("occlusion")) benchOcclusion(world);
+  if (selected("lazyhits")) benchLazyHits(world);
+  if (selected("splatting")) benchSplatting(world, materials);
+  if (selected("traversal")) benchTraversal(world, materials);
+  if (selected("spectral")) benchSpectral(world, materials);
+  if (selected("staticscene")) benchStaticScene(world, materials);
+  if (selected("tonemap")) benchToneMapping();
+  if (selected("filters")) benchFilters(world, materials);
+  if (selected("denoising")) benchDenoising(world, materials);
+
+  bool ok = true;
+  if (selected("allocs")) ok &= benchAllocations();
+
+  return ok ? 0 : 1;
+}
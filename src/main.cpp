@@ -1,67 +1,46 @@
+#include "../include/arena.h"
 #include "../include/hittable.h"
 #include "../include/hittableList.h"
-#include "../include/sphere.h"
 #include "../include/utils.h"
 #include "../include/camera.h"
+#include "../include/previewServer.h"
+#include "../include/scenes.h"
+
+#include <cstring>
+#include <string>
 
 /**
  * Main program that sets up a scene and renders it using ray tracing
+ *
+ * Supported options:
+ *   --spp N         Samples per pixel (default 500)
+ *   --width N       Image width in pixels (default 2560)
+ *   --denoise       Denoise the image using albedo/normal/depth features
+ *   --aov PREFIX    Also write PREFIXalbedo.ppm, PREFIXnormal.ppm, PREFIXdepth.ppm
+ *                   (features are gathered per row with the box filter, so these
+ *                   two cannot be combined with --by-sample or another --filter)
+ *   --by-sample     Split work across threads by sample instead of by row
+ *   --filter F      Pixel filter: box (default), gaussian, mitchell or blackman-harris
+ *   --traversal O   Pixel visiting order: scanline (default), morton or hilbert
+ *   --spectral      Trace hero wavelengths instead of RGB (glass disperses light)
+ *   --exposure EV   Brighten (or, if negative, darken) the output by EV stops
+ *   --tonemap C     Highlight curve: clip (default), reinhard or aces
+ *   --srgb          Encode with the sRGB transfer function instead of gamma 2
+ *   --dither        Dither the 8-bit output to break up banding
+ *   --hdr PATH      Also write the linear HDR image to PATH (PFM); with --region it has the
+ *                   same extent as the PPM, black outside the region even with --merge
+ *   --from-hdr PATH Skip rendering; tone-map an image saved with --hdr
+ *   --region X Y W H Trace only the W x H pixel rectangle with top-left pixel (X, Y)
+ *   --padding N     Also trace N pixels around the region for filters (denoising)
+ *   --crop          Write only the region instead of the full frame
+ *   --merge PATH    Fill the frame outside the region from the PPM image at PATH
+ *   --seed N        Make the scene and the render repeatable (N non-zero)
+ *   --dynamic       Render through the virtual hittable interface instead of
+ *                   the scene specialized for its primitive types
+ *   --interactive   Keep running, read camera commands from stdin and stream
+ *                   progressive frames to stdout (see previewServer.h)
  */
-int main() {
-  // Create an empty scene
-  hittableList world;
-
-  // Add a large sphere as the ground
-  auto groundMaterial = make_shared<lambertian>(color(0.5, 0.5, 0.5));
-  world.add(make_shared<sphere>(point3(0, -1000, 0), 1000, groundMaterial));
-
-  // Generate a random scene with many small spheres
-  for (int a = -11; a < 11; a++) {
-    for (int b = -11; b < 11; b++) {
-      // Choose a random material type
-      auto chooseMat = randomDouble();
-      
-      // Create a random center point with small random offset
-      point3 center(a + 0.9 * randomDouble(), 0.2, b + 0.9 * randomDouble());
-
-      // Ensure spheres aren't too close to the large spheres we'll add later
-      if ((center - point3(4, 0.2, 0)).length() > 0.9) {
-        shared_ptr<material> sphereMaterial;
-
-        if (chooseMat < 0.8) {
-          // Diffuse material (80% chance)
-          auto albedo = vec3::random() * vec3::random();  // Random color with gamma correction
-          sphereMaterial = make_shared<lambertian>(albedo);
-          world.add(make_shared<sphere>(center, 0.2, sphereMaterial));
-        } else if (chooseMat < 0.95) {
-          // Metal material (15% chance)
-          auto albedo = vec3::random(0.5, 1);  // Metallic colors tend to be lighter
-          auto fuzz = randomDouble(0, 0.5);    // Random fuzziness/roughness
-          sphereMaterial = make_shared<metal>(albedo, fuzz);
-          world.add(make_shared<sphere>(center, 0.2, sphereMaterial));
-        } else {
-          // Glass material (5% chance)
-          sphereMaterial = make_shared<dielectric>(1.5);  // Index of refraction for glass
-          world.add(make_shared<sphere>(center, 0.2, sphereMaterial));
-        }
-      }
-    }
-  }
-
-  // Add three large spheres as focal points of the scene
-  
-  // Large glass sphere in the center
-  auto material1 = make_shared<dielectric>(1.5);
-  world.add(make_shared<sphere>(point3(0, 1, 0), 1.0, material1));
-
-  // Large diffuse sphere to the left
-  auto material2 = make_shared<lambertian>(color(0.4, 0.2, 0.1));  // Brown
-  world.add(make_shared<sphere>(point3(-4, 1, 0), 1.0, material2));
-
-  // Large metal sphere to the right
-  auto material3 = make_shared<metal>(color(0.7, 0.6, 0.5), 0.0);  // Polished gold
-  world.add(make_shared<sphere>(point3(4, 1, 0), 1.0, material3));
-
+int main(int argc, char* argv[]) {
   // Configure the camera
   camera cam;
   
@@ -81,8 +60,131 @@ int main() {
   cam.defocusAngle = 0.6;          // Moderate depth of field effect
   cam.focusDist = 10.0;            // Focus distance to main scene elements
 
-  // Render the scene
-  cam.render(world);
+  // Command line overrides
+  bool interactive = false;
+  bool dynamic = false;
+  std::string fromHdr;
+  for (int k = 1; k < argc; k++) {
+    if (!std::strcmp(argv[k], "--spp") && k + 1 < argc) {
+      cam.samplesPerPixel = std::stoi(argv[++k]);
+    } else if (!std::strcmp(argv[k], "--width") && k + 1 < argc) {
+      cam.imageWidth = std::stoi(argv[++k]);
+    } else if (!std::strcmp(argv[k], "--denoise")) {
+      cam.denoise = true;
+    } else if (!std::strcmp(argv[k], "--aov") && k + 1 < argc) {
+      cam.aovPrefix = argv[++k];
+    } else if (!std::strcmp(argv[k], "--by-sample")) {
+      cam.partitionSamples = true;
+    } else if (!std::strcmp(argv[k], "--filter") && k + 1 < argc) {
+      std::string filter = argv[++k];
+      if (filter == "box") {
+        cam.filter = filterType::box;
+      } else if (filter == "gaussian") {
+        cam.filter = filterType::gaussian;
+      } else if (filter == "mitchell") {
+        cam.filter = filterType::mitchell;
+      } else if (filter == "blackman-harris") {
+        cam.filter = filterType::blackmanHarris;
+      } else {
+        std::cerr << "Unknown filter: " << filter << "\n";
+        return 1;
+      }
+    } else if (!std::strcmp(argv[k], "--traversal") && k + 1 < argc) {
+      std::string order = argv[++k];
+      if (order == "scanline") {
+        cam.traversal = traversalOrder::scanline;
+      } else if (order == "morton") {
+        cam.traversal = traversalOrder::morton;
+      } else if (order == "hilbert") {
+        cam.traversal = traversalOrder::hilbert;
+      } else {
+        std::cerr << "Unknown traversal order: " << order << "\n";
+        return 1;
+      }
+    } else if (!std::strcmp(argv[k], "--spectral")) {
+      cam.spectral = true;
+    } else if (!std::strcmp(argv[k], "--exposure") && k + 1 < argc) {
+      cam.toneMapping.exposure = std::stod(argv[++k]);
+    } else if (!std::strcmp(argv[k], "--tonemap") && k + 1 < argc) {
+      std::string curve = argv[++k];
+      if (curve == "clip") {
+        cam.toneMapping.curve = toneCurve::clip;
+      } else if (curve == "reinhard") {
+        cam.toneMapping.curve = toneCurve::reinhard;
+      } else if (curve == "aces") {
+        cam.toneMapping.curve = toneCurve::aces;
+      } else {
+        std::cerr << "Unknown tone curve: " << curve << "\n";
+        return 1;
+      }
+    } else if (!std::strcmp(argv[k], "--srgb")) {
+      cam.toneMapping.transfer = transferFunction::sRGB;
+    } else if (!std::strcmp(argv[k], "--dither")) {
+      cam.toneMapping.dither = true;
+    } else if (!std::strcmp(argv[k], "--hdr") && k + 1 < argc) {
+      cam.hdrPath = argv[++k];
+    } else if (!std::strcmp(argv[k], "--from-hdr") && k + 1 < argc) {
+      fromHdr = argv[++k];
+    } else if (!std::strcmp(argv[k], "--region") && k + 4 < argc) {
+      cam.useRenderRegion = true;
+      cam.regionX = std::stoi(argv[++k]);
+      cam.regionY = std::stoi(argv[++k]);
+      cam.regionWidth = std::stoi(argv[++k]);
+      cam.regionHeight = std::stoi(argv[++k]);
+    } else if (!std::strcmp(argv[k], "--padding") && k + 1 < argc) {
+      cam.regionPadding = std::stoi(argv[++k]);
+    } else if (!std::strcmp(argv[k], "--crop")) {
+      cam.cropToRegion = true;
+    } else if (!std::strcmp(argv[k], "--merge") && k + 1 < argc) {
+      cam.mergeBase = argv[++k];
+    } else if (!std::strcmp(argv[k], "--seed") && k + 1 < argc) {
+      cam.seed = std::stoull(argv[++k]);
+    } else if (!std::strcmp(argv[k], "--dynamic")) {
+      dynamic = true;
+    } else if (!std::strcmp(argv[k], "--interactive")) {
+      interactive = true;
+    } else {
+      std::cerr << "Unknown option: " << argv[k] << "\n";
+      return 1;
+    }
+  }
+
+  // Feature gathering only supports the box filter with work split by row
+  if ((cam.denoise || !cam.aovPrefix.empty()) &&
+      (cam.filter != filterType::box || cam.partitionSamples)) {
+    std::cerr << "--denoise and --aov cannot be combined with --by-sample or a "
+                 "filter other than box\n";
+    return 1;
+  }
+
+  // Re-expose a previously rendered image without tracing any rays
+  if (!fromHdr.empty()) {
+    framebuffer fb;
+    if (!readImageHDR(fromHdr, fb)) return 1;
+    writeImage(std::cout, fb, cam.toneMapping);
+    return 0;
+  }
+
+  // Create the scene and its material table, packed together in one arena
+  arena sceneArena;
+  hittableList world(sceneArena.get());
+  materialList materials(sceneArena.get());
+  if (cam.seed) seedRandom(cam.seed);
+  randomSpheresScene(world, materials, sceneArena);
+
+  // Serve interactive camera changes, or render the scene once
+  if (interactive) {
+    previewServer server(cam, world, materials);
+    server.maxSamples = cam.samplesPerPixel;
+    server.run(std::cin, std::cout);
+    return 0;
+  }
+
+  // The example scene holds only spheres, so it can use the specialized renderer
+  sphereScene specialized(sceneArena.get());
+  bool written = (dynamic || !specialized.addAll(world))
+                     ? cam.render(world, materials)
+                     : cam.render(specialized, materials);
 
-  return 0;
+  return written ? 0 : 1;
 }
\ No newline at end of file
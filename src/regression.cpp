@@ -0,0 +1,223 @@
+#include "../include/arena.h"
+#include "../include/camera.h"
+#include "../include/hittableList.h"
+#include "../include/imageIO.h"
+#include "../include/imageMetrics.h"
+#include "../include/scenes.h"
+#include "../include/utils.h"
+
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+/**
+ * Image regression harness
+ * Renders small, seeded versions of the example scene under several camera
+ * configurations and compares each with a stored reference image, so that
+ * performance work cannot silently change what is rendered. Render time and
+ * ray throughput are reported alongside the error metrics.
+ *
+ * Usage: raytracingRegression [--update] [--references DIR] [--log FILE] [name]
+ *   --update          Write the current renders as the new references
+ *   --references DIR  Directory holding the reference images
+ *   --log FILE        Append one CSV line per case to FILE
+ *   name              Run only the named case
+ *
+ * Exits with status 1 if any case misses its thresholds or has no reference,
+ * which fails the imageRegression ctest test
+ */
+
+#ifndef REGRESSION_REFERENCE_DIR
+#define REGRESSION_REFERENCE_DIR "regression"
+#endif
+
+// Seed for the scene layout and every render
+const std::uint64_t REGRESSION_SEED = 2024;
+
+// Thresholds a render must meet against its reference
+const double MIN_PSNR = 40;    // Decibels
+const double MAX_FLIP = 0.01;  // Mean FLIP-style error
+
+/**
+ * Scene wrapper that counts the closest-hit queries made through it
+ * Every traced ray makes exactly one query, so this counts rays without
+ * touching the renderer. Counts are kept per pool thread to avoid contention.
+ */
+template <typename World>
+class countingScene {
+ public:
+  explicit countingScene(const World& world)
+      : world(world), counts(threadPool::instance().size()) {}
+
+  bool hit(const ray& r, interval rayT, hitRecord& rec) const {
+    counts[threadPool::threadIndex()].rays++;
+    return world.hit(r, rayT, rec);
+  }
+
+  // Total rays traced so far
+  long rays() const {
+    long total = 0;
+    for (const auto& c : counts) total += c.rays;
+    return total;
+  }
+
+ private:
+  // Per-thread counter on its own cache line
+  struct alignas(64) counter {
+    long rays = 0;
+  };
+
+  const World& world;                    // Scene being counted
+  mutable std::vector<counter> counts;  // One counter per pool thread
+};
+
+/**
+ * One camera configuration to render and check
+ */
+struct regressionCase {
+  const char* name;              // Case name
+  const char* reference;         // Reference image name (several cases may share one)
+  bool dynamicScene;             // Render through the virtual hittable interface
+  void (*configure)(camera&);    // Settings applied on top of the base camera
+};
+
+const regressionCase CASES[] = {
+    {"default", "default", false, [](camera&) {}},
+    // Must match the specialized scene's reference
+    {"dynamic", "default", true, [](camera&) {}},
+    {"hilbert", "hilbert", false, [](camera& cam) { cam.traversal = traversalOrder::hilbert; }},
+    {"bysample", "bysample", false, [](camera& cam) { cam.partitionSamples = true; }},
+    {"gaussian", "gaussian", false, [](camera& cam) { cam.filter = filterType::gaussian; }},
+    {"spectral", "spectral", false, [](camera& cam) { cam.spectral = true; }},
+    {"denoise", "denoise", false, [](camera& cam) { cam.denoise = true; }},
+};
+
+/**
+ * Convert 8-bit display values to a framebuffer of values in [0,1]
+ */
+framebuffer displayImage(int width, int height, const std::vector<unsigned char>& bytes) {
+  framebuffer fb(width, height);
+  for (int p = 0; p < fb.size(); p++) {
+    fb.pixels[p] = color(bytes[3 * p], bytes[3 * p + 1], bytes[3 * p + 2]) / 255.0;
+  }
+  return fb;
+}
+
+int main(int argc, char* argv[]) {
+  bool update = false;
+  std::string referenceDir = REGRESSION_REFERENCE_DIR;
+  std::string logPath;
+  const char* name = nullptr;
+  for (int k = 1; k < argc; k++) {
+    if (!std::strcmp(argv[k], "--update")) {
+      update = true;
+    } else if (!std::strcmp(argv[k], "--references") && k + 1 < argc) {
+      referenceDir = argv[++k];
+    } else if (!std::strcmp(argv[k], "--log") && k + 1 < argc) {
+      logPath = argv[++k];
+    } else if (argv[k][0] != '-') {
+      name = argv[k];
+    } else {
+      std::cerr << "Unknown option: " << argv[k] << "\n";
+      return 1;
+    }
+  }
+
+  // Render progress would interleave with the report
+  std::clog.rdbuf(nullptr);
+
+  // The scene layout is random too, so it is seeded like the renders
+  arena sceneArena;
+  hittableList world(sceneArena.get());
+  materialList materials(sceneArena.get());
+  seedRandom(REGRESSION_SEED);
+  randomSpheresScene(world, materials, sceneArena);
+  sphereScene specialized(sceneArena.get());
+  specialized.addAll(world);
+
+  std::ofstream log;
+  if (!logPath.empty()) {
+    bool fresh = !std::ifstream(logPath).good();
+    log.open(logPath, std::ios::app);
+    if (fresh) log << "time,case,seconds,mrays_per_second,rmse,psnr,flip,status\n";
+  }
+
+  bool ok = true;
+  for (const auto& test : CASES) {
+    if (name && std::strcmp(name, test.name)) continue;
+
+    camera cam = exampleCamera(160, 16);
+    cam.defocusAngle = 0.6;
+    cam.focusDist = 10.0;
+    cam.seed = REGRESSION_SEED;
+    test.configure(cam);
+
+    // Render and time it, including any denoising
+    framebuffer fb;
+    long rays = 0;
+    auto renderWith = [&](const auto& scene) {
+      countingScene counted(scene);
+      auto start = std::chrono::steady_clock::now();
+      fb = cam.renderImage(counted, materials);
+      if (cam.denoise) cam.denoiserSettings.apply(fb);
+      rays = counted.rays();
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    double seconds = test.dynamicScene ? renderWith(static_cast<const hittable&>(world))
+                                       : renderWith(specialized);
+    double mrays = rays / seconds / 1e6;
+
+    std::vector<unsigned char> bytes;
+    toneMapper().apply(fb, bytes);
+    std::string referencePath = referenceDir + "/" + test.reference + ".ppm";
+
+    std::cout << std::left << std::setw(10) << test.name << std::right << std::fixed
+              << std::setprecision(3) << std::setw(7) << seconds << " s "
+              << std::setprecision(2) << std::setw(7) << mrays << " Mrays/s";
+
+    if (update) {
+      // Cases sharing a reference must not overwrite the one that defines it
+      if (!std::strcmp(test.name, test.reference)) {
+        std::ofstream out(referencePath, std::ios::binary);
+        writeImageBinary(out, fb);
+        std::cout << "  updated " << referencePath << "\n";
+      } else {
+        std::cout << "  (uses " << test.reference << ")\n";
+      }
+      continue;
+    }
+
+    int width = 0, height = 0;
+    std::vector<unsigned char> referenceBytes;
+    if (!readImageBytes(referencePath, width, height, referenceBytes) ||
+        width != fb.width || height != fb.height) {
+      std::cout << "  FAIL: no usable reference " << referencePath << "\n";
+      ok = false;
+      continue;
+    }
+
+    framebuffer reference = displayImage(width, height, referenceBytes);
+    framebuffer image = displayImage(fb.width, fb.height, bytes);
+    double rmse = imageRMSE(reference, image);
+    double psnr = imagePSNR(reference, image);
+    double flip = imageFLIP(reference, image);
+    bool pass = psnr >= MIN_PSNR && flip <= MAX_FLIP;
+    ok &= pass;
+
+    std::cout << "  RMSE " << std::setprecision(5) << rmse << "  PSNR "
+              << std::setprecision(1) << psnr << " dB  FLIP " << std::setprecision(5)
+              << flip << (pass ? "  ok\n" : "  FAIL\n");
+
+    if (log.is_open()) {
+      log << std::time(nullptr) << ',' << test.name << ',' << seconds << ',' << mrays
+          << ',' << rmse << ',' << psnr << ',' << flip << ','
+          << (pass ? "ok" : "fail") << '\n';
+    }
+  }
+
+  return ok ? 0 : 1;
+}